@@ -0,0 +1,274 @@
+#include "CppSweeper.h"
+#include "CppSweeperFormat.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+// O------------------------------------------------------------------------------O
+// | Analyses single positions: loads each position into a game, lets the engine  |
+// | choose a move and prints the mine probabilities of the covered cells, the	  |
+// | recommended move and the statistics of the search. In the text output,	  |
+// | covered cells show their mine probability in percent.						  |
+// | Positions are read as text or as a corpus in the binary format. The text	  |
+// | format is a line "width height mines" followed by one line per row, with	  |
+// | '0'-'8' for revealed cells, '.' for covered and 'F' for flagged cells.		  |
+// O------------------------------------------------------------------------------O
+class AnalyzeSweeper
+{
+public:
+    std::string methodName = "backtracking";
+    long long maxSamples = 1000000;
+    //Search nodes the exact method may spend per component before it falls back to backtracking
+    long long maxNodes = 20000000;
+    bool rotate = true;
+    bool json = false;
+    //Seed of the random numbers used by the stochastic methods; -1 leaves the time-based seed of CppSweeper
+    long long seed = -1;
+
+    bool configure(CppSweeper_AI* AI)
+    {
+        AI->maxSamples = maxSamples;
+        AI->exactMaxNodes = maxNodes;
+        AI->rotate = rotate;
+        if (methodName == "backtracking")
+            AI->stochasticMethod = StochasticMethod::METHOD_BACKTRACKING;
+        else if (methodName == "exact")
+            AI->stochasticMethod = StochasticMethod::METHOD_EXACT;
+        else if (methodName == "cascade")
+            AI->stochasticMethod = StochasticMethod::METHOD_CASCADE;
+        else if (methodName == "belief")
+            AI->stochasticMethod = StochasticMethod::METHOD_BELIEF;
+        else if (methodName == "average")
+            AI->stochasticMethod = StochasticMethod::METHOD_AVGCONSTRAINT;
+        else if (methodName == "single")
+            AI->stochasticMethod = StochasticMethod::METHOD_SINGLECONSTRAINT;
+        else if (methodName == "random")
+            AI->stochasticMethod = StochasticMethod::METHOD_RND;
+        else
+            return false;
+        return true;
+    }
+
+    static bool parseText(std::istream& in, SweeperPosition* position)
+    {
+        if (!(in >> position->width >> position->height >> position->mineCount) || (position->width <= 0) || (position->height <= 0))
+            return false;
+        position->cells.assign(position->width * position->height, SweeperPosition::COVERED);
+        position->mines.clear();
+        std::string row;
+        for (int y = 0; y < position->height; y++)
+        {
+            if (!(in >> row) || ((int)row.size() != position->width))
+                return false;
+            for (int x = 0; x < position->width; x++)
+            {
+                char c = row[x];
+                if ((c >= '0') && (c <= '8'))
+                    position->cells[x + y * position->width] = c - '0';
+                else if (c == 'F')
+                    position->cells[x + y * position->width] = SweeperPosition::FLAGGED;
+                else if (c != '.')
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    //The probability reported for a covered cell: 1 for a known mine, -1 if the method left none (such as 0/0 when no mines
+    //are left to place)
+    static double reportedProbability(const VisibleCell* cell)
+    {
+        if (cell->knownMine)
+            return 1.0;
+        if (!std::isfinite(cell->mineProbability) || (cell->mineProbability < 0.0))
+            return -1.0;
+        return cell->mineProbability;
+    }
+
+    void analyse(const SweeperPosition& position, int index)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        CppSweeper game;
+        CppSweeper_AI AI;
+        configure(&AI);
+        if (seed >= 0)
+            game.seed((unsigned int)seed);
+        game.AI = &AI;
+        game.loadPosition(position);
+
+        //A position without a cell left to click has no move
+        std::tuple<int, int> move(-1, -1);
+        if (game.moveLeft())
+        {
+            move = AI.move(&game);
+            //A deduced move does not estimate probabilities; run the stochastic method anyway to report them
+            if (AI.lastMove.moveType == MoveType::MOVE_DETERMINISTIC)
+                AI.stages().stochasticMove(&game);
+            //The exact method only samples once a component needs more than maxNodes nodes
+            if ((methodName == "exact") && (AI.samples() > 0))
+                std::cerr << "Position " << index << ": exact enumeration exceeded " << maxNodes << " nodes, fell back to backtracking" << std::endl;
+        }
+        double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+        const char* moveType = "none";
+        double moveProbability = 0.0;
+        if (std::get<0>(move) >= 0)
+        {
+            //An exact probability of zero is as safe as a deduced move
+            bool safe = (AI.lastMove.moveType == MoveType::MOVE_DETERMINISTIC) || ((methodName == "exact") && (AI.samples() == 0) && (AI.lastMove.probability == 0.0));
+            moveType = safe ? "safe" : "guess";
+            moveProbability = safe ? 0.0 : AI.lastMove.probability;
+        }
+        const AI_Stats& stats = AI.lastStats();
+
+        if (json)
+        {
+            std::cout << "{\"position\":" << index << ",\"width\":" << game.width << ",\"height\":" << game.height << ",\"mines\":" << game.mineCount
+                << ",\"method\":\"" << methodName << "\",\"move\":";
+            if (std::get<0>(move) >= 0)
+                std::cout << "{\"x\":" << std::get<0>(move) << ",\"y\":" << std::get<1>(move) << ",\"type\":\"" << moveType << "\",\"probability\":" << moveProbability << "}";
+            else
+                std::cout << "null";
+            std::cout << ",\"probabilities\":[";
+            for (int y = 0; y < game.height; y++)
+            {
+                std::cout << (y > 0 ? ",[" : "[");
+                for (int x = 0; x < game.width; x++)
+                {
+                    VisibleCell* cell = game.getCell(x, y);
+                    std::cout << (x > 0 ? "," : "");
+                    if (cell->clicked || (reportedProbability(cell) < 0.0))
+                        std::cout << "null";
+                    else
+                        std::cout << reportedProbability(cell);
+                }
+                std::cout << "]";
+            }
+            std::cout << "],\"stats\":{\"time_us\":" << time << ",\"deduction_us\":" << stats.deductionTime << ",\"search_us\":" << stats.searchTime
+                << ",\"samples\":" << AI.samples() << ",\"search_nodes\":" << stats.searchNodes << ",\"pruned\":" << stats.prunedBranches
+                << ",\"pattern_hits\":" << stats.patternHits << ",\"cache_hits\":" << stats.cacheHits
+                << ",\"components\":" << stats.components << ",\"largest_component\":" << stats.largestComponent
+                << ",\"constrained_cells\":" << stats.constrainedCells << "}}" << std::endl;
+        }
+        else
+        {
+            std::cout << "Position " << index << " (" << game.width << "x" << game.height << ", " << game.mineCount << " mines), method " << methodName << std::endl;
+            for (int y = 0; y < game.height; y++)
+            {
+                for (int x = 0; x < game.width; x++)
+                {
+                    VisibleCell* cell = game.getCell(x, y);
+                    std::string s;
+                    if (cell->clicked)
+                        s = std::to_string(cell->neighbouringMines);
+                    else if (cell->flag)
+                        s = "F";
+                    else if (reportedProbability(cell) < 0.0)
+                        s = "?";
+                    else
+                        s = std::to_string((int)(reportedProbability(cell) * 100.0 + 0.5)) + "%";
+                    std::cout << std::string(5 - s.size(), ' ') << s;
+                }
+                std::cout << std::endl;
+            }
+            if (std::get<0>(move) >= 0)
+                std::cout << "Move: (" << std::get<0>(move) << "," << std::get<1>(move) << ") " << moveType << ", mine probability " << moveProbability << std::endl;
+            else
+                std::cout << "Move: none" << std::endl;
+            std::cout << "Time " << time << "us (deduction " << stats.deductionTime << "us, search " << stats.searchTime << "us), "
+                << AI.samples() << " samples, " << stats.components << " components (largest " << stats.largestComponent << ")" << std::endl;
+        }
+    }
+
+    //Reads a corpus if the input starts with the corpus header and a text position otherwise
+    bool run(const std::string& path)
+    {
+        SweeperCorpus corpus;
+        std::string input;
+        if ((path != "-") && corpus.open(path))
+            return runCorpus(&corpus);
+        if (path == "-")
+            input.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        else
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                std::cerr << "Cannot open " << path << std::endl;
+                return false;
+            }
+            input.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        if (corpus.attach((const uint8_t*)input.data(), input.size()))
+            return runCorpus(&corpus);
+
+        std::istringstream in(input);
+        SweeperPosition position;
+        if (!parseText(in, &position))
+        {
+            std::cerr << "Malformed position" << std::endl;
+            return false;
+        }
+        analyse(position, 0);
+        return true;
+    }
+
+    bool runCorpus(SweeperCorpus* corpus)
+    {
+        SweeperRecord record;
+        SweeperPosition position;
+        int index = 0;
+        while (corpus->next(&record))
+            if (record.kind == RecordKind::RECORD_POSITION)
+            {
+                record.toPosition(&position);
+                analyse(position, index++);
+            }
+        if (corpus->corrupt())
+        {
+            std::cerr << "Corpus truncated after " << index << " positions" << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    AnalyzeSweeper analyzer;
+    std::string path = "-";
+    bool usage = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--method") && (i + 1 < argc))
+            analyzer.methodName = argv[++i];
+        else if ((arg == "--samples") && (i + 1 < argc))
+            analyzer.maxSamples = std::atoll(argv[++i]);
+        else if ((arg == "--nodes") && (i + 1 < argc))
+            analyzer.maxNodes = std::atoll(argv[++i]);
+        else if ((arg == "--rotate") && (i + 1 < argc))
+            analyzer.rotate = std::atoi(argv[++i]) != 0;
+        else if ((arg == "--seed") && (i + 1 < argc))
+            analyzer.seed = std::atoll(argv[++i]);
+        else if (arg == "--json")
+            analyzer.json = true;
+        else if ((arg.size() > 0) && ((arg[0] != '-') || (arg == "-")))
+            path = arg;
+        else
+            usage = true;
+    }
+    CppSweeper_AI probe;
+    if (usage || !analyzer.configure(&probe))
+    {
+        std::cerr << "Usage: AnalyzeSweeper [--method backtracking|exact|cascade|belief|average|single|random] [--samples n] [--nodes n] [--rotate 0|1] [--seed s] [--json] [position|-]" << std::endl;
+        return 1;
+    }
+    return analyzer.run(path) ? 0 : 1;
+}
@@ -0,0 +1,342 @@
+#include "CppSweeper.h"
+#include "CppSweeperFormat.h"
+#include "CppSweeperTiles.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+//Every heap allocation of the process is counted, to report allocations per operation
+static std::atomic<long long> allocations(0);
+
+static void* countedAllocation(std::size_t size)
+{
+    allocations++;
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size)
+{
+    return countedAllocation(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// O------------------------------------------------------------------------------O
+// | A fixed set of positions in which the engine had to guess, recorded from	  |
+// | seeded games so that every run of the benchmark sees the same positions.	  |
+// O------------------------------------------------------------------------------O
+struct Corpus
+{
+    std::string name;
+    std::vector<SweeperPosition> positions;
+};
+
+// O------------------------------------------------------------------------------O
+// | Times the stages of the engine in isolation. Each result is written as one	  |
+// | JSON object per line, so that runs of different builds can be diffed.		  |
+// O------------------------------------------------------------------------------O
+class BenchSweeper
+{
+public:
+    int iterations = 20;
+    int games = 10;
+    long long searchBudget = 20000;
+    //With more than one thread the label stage runs tiled on every board
+    int threads = 1;
+    unsigned int seedBase = 1;
+    std::string loadPath;
+    std::string savePath;
+    std::vector<Corpus> corpora;
+
+    //Plays seeded games with the engine and records each position in which it has to guess
+    Corpus recordCorpus(const std::string& name, int width, int height, int mineCount)
+    {
+        Corpus corpus;
+        corpus.name = name;
+        CppSweeper game;
+        CppSweeper_AI AI;
+        game.AI = &AI;
+        AI.maxSamples = 10000;
+        game.width = width;
+        game.height = height;
+        game.mineCount = mineCount;
+        for (int g = 0; g < games; g++)
+        {
+            game.seed(seedBase + g);
+            game.resetGame();
+            while (!game.gameWon() && !game.gameLost())
+            {
+                SweeperPosition position = game.getPosition();
+                std::tuple<int, int> move = AI.move(&game);
+                if (move == std::tuple<int, int>(-1, -1))
+                    break;
+                if (AI.lastMove.moveType == MoveType::MOVE_PROBABILISTIC)
+                    corpus.positions.push_back(position);
+                game.click(std::get<0>(move), std::get<1>(move));
+            }
+        }
+        return corpus;
+    }
+
+    void report(const std::string& stage, const Corpus& corpus, long long ops, double seconds, long long allocs, long long samples)
+    {
+        std::cout << "{\"stage\":\"" << stage << "\",\"corpus\":\"" << corpus.name << "\",\"positions\":" << corpus.positions.size()
+            << ",\"ops\":" << ops << ",\"ns_per_op\":" << (ops > 0 ? seconds * 1e9 / ops : 0.0)
+            << ",\"allocs_per_op\":" << (ops > 0 ? (double)allocs / ops : 0.0);
+        if (samples >= 0)
+            std::cout << ",\"samples\":" << samples << ",\"samples_per_sec\":" << (seconds > 0 ? samples / seconds : 0.0);
+        std::cout << "}" << std::endl;
+    }
+
+    void benchGenerateField(const Corpus& corpus)
+    {
+        if (corpus.positions.size() == 0)
+            return;
+        CppSweeper game;
+        game.width = corpus.positions[0].width;
+        game.height = corpus.positions[0].height;
+        game.mineCount = corpus.positions[0].mineCount;
+        game.seed(seedBase);
+
+        double seconds = 0.0;
+        long long allocs = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            game.resetGame();
+            long long allocsBefore = allocations;
+            auto begin = std::chrono::steady_clock::now();
+            game.generateField(game.width / 2, game.height / 2);
+            auto end = std::chrono::steady_clock::now();
+            allocs += allocations - allocsBefore;
+            seconds += std::chrono::duration<double>(end - begin).count();
+        }
+        report("generateField", corpus, iterations, seconds, allocs, -1);
+    }
+
+    //Replays the reveals of each position through updateKnowledge
+    void benchUpdateKnowledge(const Corpus& corpus)
+    {
+        double seconds = 0.0;
+        long long allocs = 0;
+        long long ops = 0;
+        for (auto itr = corpus.positions.begin(); itr != corpus.positions.end(); itr++)
+        {
+            CppSweeper game;
+            CppSweeper_AI AI;
+            for (int i = 0; i < iterations; i++)
+            {
+                game.loadPosition(*itr);
+                AI.reset();
+                long long allocsBefore = allocations;
+                auto begin = std::chrono::steady_clock::now();
+                for (int x = 0; x < game.width; x++)
+                    for (int y = 0; y < game.height; y++)
+                        if (game.getCell(x, y)->clicked)
+                        {
+                            AI.updateKnowledge(&game, x, y);
+                            ops++;
+                        }
+                auto end = std::chrono::steady_clock::now();
+                allocs += allocations - allocsBefore;
+                seconds += std::chrono::duration<double>(end - begin).count();
+            }
+        }
+        report("updateKnowledge", corpus, ops, seconds, allocs, -1);
+    }
+
+    //Times labelConnectedComponents, boundaryBacktracking (per component, with a fixed sample budget) and setProbabilitiesFromSamples
+    void benchSearch(const Corpus& corpus)
+    {
+        double labelSeconds = 0.0, searchSeconds = 0.0, probabilitySeconds = 0.0;
+        long long labelAllocs = 0, searchAllocs = 0, probabilityAllocs = 0;
+        long long labelOps = 0, searchOps = 0, probabilityOps = 0;
+        long long samples = 0;
+        std::shared_ptr<TilePool> pool = std::make_shared<TilePool>(threads);
+        for (auto itr = corpus.positions.begin(); itr != corpus.positions.end(); itr++)
+        {
+            CppSweeper game;
+            CppSweeper_AI AI;
+            game.AI = &AI;
+            AI.tileThreads = threads;
+            AI.tilePool = pool;
+            if (threads > 1)
+                AI.tileMinCells = 0;
+            game.loadPosition(*itr);
+            CppSweeper_AI::Stages stages = AI.stages();
+            stages.gaussianDeduction(&game);
+            for (int i = 0; i < iterations; i++)
+            {
+                std::vector<VisibleCell*> boundary;
+                std::vector<VisibleCell*> cellsToSet;
+                stages.collectBoundary(&game, &boundary, &cellsToSet);
+
+                long long allocsBefore = allocations;
+                auto begin = std::chrono::steady_clock::now();
+                stages.labelConnectedComponents(&game, &cellsToSet, &boundary);
+                auto end = std::chrono::steady_clock::now();
+                labelAllocs += allocations - allocsBefore;
+                labelSeconds += std::chrono::duration<double>(end - begin).count();
+                labelOps++;
+
+                for (unsigned c = 0; c < stages.components().size(); c++)
+                {
+                    ConnectedComponent& component = stages.components()[c];
+                    stages.prepareSearch(&game, component, searchBudget);
+
+                    allocsBefore = allocations;
+                    begin = std::chrono::steady_clock::now();
+                    long long taken = stages.search(&game, component);
+                    end = std::chrono::steady_clock::now();
+                    searchAllocs += allocations - allocsBefore;
+                    searchSeconds += std::chrono::duration<double>(end - begin).count();
+                    searchOps++;
+                    samples += taken;
+                    for (auto cell = component.cellsToSet.begin(); cell != component.cellsToSet.end(); cell++)
+                        (*cell)->simMine = false;
+                }
+
+                allocsBefore = allocations;
+                begin = std::chrono::steady_clock::now();
+                stages.setProbabilitiesFromSamples(&game, &cellsToSet);
+                end = std::chrono::steady_clock::now();
+                probabilityAllocs += allocations - allocsBefore;
+                probabilitySeconds += std::chrono::duration<double>(end - begin).count();
+                probabilityOps++;
+            }
+        }
+        report("labelConnectedComponents", corpus, labelOps, labelSeconds, labelAllocs, -1);
+        report("boundaryBacktracking", corpus, searchOps, searchSeconds, searchAllocs, samples);
+        report("setProbabilitiesFromSamples", corpus, probabilityOps, probabilitySeconds, probabilityAllocs, -1);
+    }
+
+    //Reads the positions of a corpus file, grouping them by board size
+    bool loadCorpora(const std::string& path)
+    {
+        SweeperCorpus file;
+        if (!file.open(path))
+            return false;
+        SweeperRecord record;
+        while (file.next(&record))
+        {
+            if (record.kind != RecordKind::RECORD_POSITION)
+                continue;
+            std::string name = std::to_string(record.width) + "x" + std::to_string(record.height) + "_" + std::to_string(record.mineCount);
+            auto corpus = std::find_if(corpora.begin(), corpora.end(), [&name](const Corpus& c) { return c.name == name; });
+            if (corpus == corpora.end())
+            {
+                corpora.push_back(Corpus{ name, std::vector<SweeperPosition>() });
+                corpus = corpora.end() - 1;
+            }
+            corpus->positions.push_back(SweeperPosition());
+            record.toPosition(&corpus->positions.back());
+        }
+        return !file.corrupt();
+    }
+
+    bool saveCorpora(const std::string& path)
+    {
+        SweeperCorpusWriter file;
+        if (!file.open(path))
+            return false;
+        for (auto corpus = corpora.begin(); corpus != corpora.end(); corpus++)
+            for (auto position = corpus->positions.begin(); position != corpus->positions.end(); position++)
+                file.write(*position);
+        return file.close();
+    }
+
+    bool run()
+    {
+        if (loadPath.size() > 0)
+        {
+            if (!loadCorpora(loadPath))
+            {
+                std::cerr << "Cannot read corpus " << loadPath << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            corpora.push_back(recordCorpus("beginner", 9, 9, 10));
+            corpora.push_back(recordCorpus("intermediate", 16, 16, 40));
+            corpora.push_back(recordCorpus("expert", 30, 16, 99));
+            corpora.push_back(recordCorpus("custom_100x100", 100, 100, 2000));
+        }
+        if ((savePath.size() > 0) && !saveCorpora(savePath))
+        {
+            std::cerr << "Cannot write corpus " << savePath << std::endl;
+            return false;
+        }
+        for (auto itr = corpora.begin(); itr != corpora.end(); itr++)
+        {
+            benchGenerateField(*itr);
+            benchUpdateKnowledge(*itr);
+            benchSearch(*itr);
+        }
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    BenchSweeper bench;
+    bool usage = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            usage = true;
+        else if (arg == "--iterations")
+            bench.iterations = std::atoi(argv[++i]);
+        else if (arg == "--games")
+            bench.games = std::atoi(argv[++i]);
+        else if (arg == "--budget")
+            bench.searchBudget = std::atoll(argv[++i]);
+        else if (arg == "--threads")
+            bench.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed")
+            bench.seedBase = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--load")
+            bench.loadPath = argv[++i];
+        else if (arg == "--save")
+            bench.savePath = argv[++i];
+        else
+            usage = true;
+    }
+    if (usage)
+    {
+        std::cerr << "Usage: BenchSweeper [--iterations n] [--games n] [--budget samples] [--threads n] [--seed s] [--load corpus] [--save corpus]" << std::endl;
+        return 1;
+    }
+    return bench.run() ? 0 : 1;
+}
@@ -1,5 +1,9 @@
 #define OLC_PGE_APPLICATION
 #include "CppSweeper.h"
+#include "CppSweeperTrace.h"
+#include "CppSweeperShared.h"
+#include "CppSweeperSpeculation.h"
+#include "CppSweeperTablebase.h"
 #include "olcPixelGameEngine.h"
 #include <iostream>
 #include <iomanip>
@@ -16,10 +20,21 @@ class ConsoleSweeper : public olc::PixelGameEngine
 public:
     CppSweeper game;
     CppSweeper_AI AI;
+    //Solved components, mapped at startup if CppSweeper_tablebase.bin (cf. TablebaseSweeper) is present
+    SweeperTablebase tablebase;
+    //Solves each position in the background right after a reveal, and the positions after the likely next moves
+    SweeperSpeculation speculation;
+    bool continuousAnalysis = true;
+    //Publishes the engine state after every move into the shared memory segment "CppSweeper" while open (cf. WatchSweeper)
+    SweeperMapPublisher publisher;
+    //The probability labels drawn on the cells, "0" to "100"
+    std::vector<std::string> percentLabels;
     std::thread ai_thread;
     std::mutex m;
     //The queue of moves made by the AI, to be displayed in the top menu
     std::vector<AI_Move> AImoves;
+    //Performance counters of all AI moves since the last reset of the stats
+    AI_StatsAggregate AIstats;
     //1: Beginner, 2: Advanced, 3: Expert
     char difficulty = 3;
     //The width and height of each cell in pixels
@@ -42,6 +57,7 @@ public:
     bool ai_thread_spawned = false;
     bool ai_thread_working = false;
     bool ai_thread_interrupt = false;
+    AIJob ai_job = AIJob::MOVE;
     //The number of AI games to to be done (unless interrupted)
     int ai_loop_counter = 0;
     //The total number of AI games done in a loop
@@ -139,7 +155,13 @@ public:
     {
         game.AI = &AI;
         game.AI->m = &m;
+        if (tablebase.open("CppSweeper_tablebase.bin"))
+            AI.tablebase = &tablebase;
+        AI.speculation = &speculation;
+        for (int p = 0; p <= 100; p++)
+            percentLabels.push_back(std::to_string(p));
         sAppName = "CppSweeper";
+        TRACE_THREAD_NAME("frontend");
         return true;
     }
 
@@ -151,6 +173,11 @@ public:
             AI.interrupt = true;
             ai_thread.join();
         }
+        AI.speculation = nullptr;
+        speculation.clear();
+        AI.publisher = nullptr;
+        publisher.close();
+        TRACE_DUMP("CppSweeper_trace.json");
         return true;
     }
 
@@ -180,7 +207,11 @@ public:
     bool AIMove(bool execute)
     {
         std::tuple<int, int> move = AI.move(&game);
-        while (!m.try_lock());
+        {
+            TRACE_SCOPE("lock wait");
+            while (!m.try_lock());
+        }
+        AIstats.add(AI.lastStats());
         if (AImoves.size() > 17)
             AImoves.erase(AImoves.begin());
         AImoves.push_back(AI.lastMove);
@@ -216,6 +247,7 @@ public:
 
     void AI_thread(AIJob job)
     {
+        TRACE_THREAD_NAME("AI");
         ai_thread_working = true;
         switch (job)
         {
@@ -274,7 +306,10 @@ public:
     {
         int offset = 15;
         DrawString(posX, posY + 5, "KNOWLEDGE", olc::CYAN, 1);
-        while (!m.try_lock());
+        {
+            TRACE_SCOPE("lock wait");
+            while (!m.try_lock());
+        }
         std::vector<KnowledgeDatum> knowledge = AI.getKnowledge();
         for (auto itr = knowledge.begin(); itr != knowledge.end(); itr++)
         {
@@ -311,13 +346,18 @@ public:
     void drawProbabilities(int posX, int posY)
     {
         int offsetX = 0;
-        int offsetY = 45;
+        int offsetY = 65;
         long long samples = AI.samples();
         long long validSamples = AI.validSamples();
         DrawString(posX, posY + 5, "PROBABILISTIC ENGINE", olc::CYAN, 1);
         DrawString(posX, posY + 15, "Samples: " + std::to_string(samples * 100 / AI.maxSamples) + "%", olc::CYAN, 1);
         DrawString(posX, posY + 25, "Connected Components: " + std::to_string(AI.connectedComponents()), olc::CYAN, 1);
         DrawString(posX, posY + 35, "Boundary configurations found: " + std::to_string(validSamples), olc::CYAN, 1);
+        const AI_Stats& stats = AI.lastStats();
+        DrawString(posX, posY + 45, "Last move: " + floatToString(stats.totalTime / 1000, 1) + "ms (search " + floatToString(stats.searchTime / 1000, 1) +
+            ", label " + floatToString(stats.labelTime / 1000, 1) + ", deduce " + floatToString(stats.deductionTime / 1000, 1) + ")", olc::CYAN, 1);
+        DrawString(posX, posY + 55, "Nodes: " + std::to_string(stats.searchNodes) + "  Pruned: " + std::to_string(stats.prunedBranches) +
+            "  Leaves: " + std::to_string(stats.leaves) + "  Largest: " + std::to_string(stats.largestComponent), olc::CYAN, 1);
         std::string s;
         for (int x = 0; x < game.width; x++)
         {
@@ -417,7 +457,7 @@ public:
                         FillRect(std::get<0>(screenCoord), std::get<1>(screenCoord), cellWH, cellWH, olc::CYAN);
                     else
                         FillRect(std::get<0>(screenCoord), std::get<1>(screenCoord), cellWH, cellWH, olc::DARK_CYAN);
-                    DrawString(std::get<0>(screenCoord) + cellWH / 10, std::get<1>(screenCoord) + cellWH / 3, std::to_string((int)(cell->mineProbability*100)), olc::RED, 1);
+                    DrawString(std::get<0>(screenCoord) + cellWH / 10, std::get<1>(screenCoord) + cellWH / 3, percentLabels[max(min((int)(cell->mineProbability * 100), 100), 0)], olc::RED, 1);
                 }
                 else
                     FillRect(std::get<0>(screenCoord), std::get<1>(screenCoord), cellWH, cellWH, olc::BLACK);
@@ -460,6 +500,8 @@ public:
         DrawString(5, menuH + 130, "G     : AI Game", olc::WHITE, 1);
         DrawString(5, menuH + 140, "L     : Toggle AI Loop", olc::WHITE, 1);
         DrawString(5, menuH + 150, "S     : Toggle Stochastic Method", olc::WHITE, 1);
+        DrawString(5, menuH + 180, "C     : Toggle Continuous Analysis (" + std::string(continuousAnalysis ? "on" : "off") + ")", olc::WHITE, 1);
+        DrawString(5, menuH + 190, "P     : Toggle Shared Map (" + std::string(publisher.isOpen() ? "on" : "off") + ")", olc::WHITE, 1);
         std::string maxSamples;
         switch (AI.stochasticMethod) {
         case StochasticMethod::METHOD_BACKTRACKING:
@@ -470,14 +512,23 @@ public:
                 maxSamples = std::to_string(AI.maxSamples / 1000) + " k";
             DrawString(5, menuH + 170, "  +/-: Adjust Samples (" + maxSamples + ")", olc::WHITE, 1);
             break;
+        case StochasticMethod::METHOD_EXACT:
+            DrawString(5, menuH + 160, "  (2) Exact (Frontier DP)", olc::WHITE, 1);
+            break;
+        case StochasticMethod::METHOD_CASCADE:
+            DrawString(5, menuH + 160, "  (3) Cascade (Exact, then Sampling)", olc::WHITE, 1);
+            break;
+        case StochasticMethod::METHOD_BELIEF:
+            DrawString(5, menuH + 160, "  (4) Belief Propagation", olc::WHITE, 1);
+            break;
         case StochasticMethod::METHOD_AVGCONSTRAINT:
-            DrawString(5, menuH + 160, "  (2) Min. Average Constraint", olc::WHITE, 1);
+            DrawString(5, menuH + 160, "  (5) Min. Average Constraint", olc::WHITE, 1);
             break;
         case StochasticMethod::METHOD_SINGLECONSTRAINT:
-            DrawString(5, menuH + 160, "  (3) Min. Single Constraint", olc::WHITE, 1);
+            DrawString(5, menuH + 160, "  (6) Min. Single Constraint", olc::WHITE, 1);
             break;
         default:
-            DrawString(5, menuH + 160, "  (4) Random", olc::WHITE, 1);
+            DrawString(5, menuH + 160, "  (7) Random", olc::WHITE, 1);
         }
 
         DrawString(5, menuH + 200, "STATS", olc::WHITE, 1);
@@ -490,6 +541,8 @@ public:
             DrawString(5, menuH + 270, "Seconds/game: " + std::to_string(ai_loop_time / ai_loop_games), olc::WHITE, 1);
         DrawString(5, menuH + 280, "Moves       : " + std::to_string(AI.moves));
         DrawString(5, menuH + 290, "Guesses     : " + std::to_string(AI.guesses) + ", " + std::to_string(((float)AI.guesses * 100) / (AI.moves)) + "%");
+        DrawString(5, menuH + 300, "Move p50/p99: " + floatToString(AIstats.percentile(0.5) / 1000, 1) + "/" + floatToString(AIstats.percentile(0.99) / 1000, 1) + " ms");
+        DrawString(5, menuH + 310, "Move max    : " + floatToString(AIstats.maxTime / 1000, 1) + " ms");
 
     }
 
@@ -500,6 +553,7 @@ public:
         game.resetStats();
         AI.moves = 0;
         AI.guesses = 0;
+        AIstats.reset();
         gameTime = 0.0f;
     }
 
@@ -508,14 +562,26 @@ public:
         return (game.gameLost() || game.gameWon());
     }
 
+    //Hands the current position to the background analysis, so that the next AI move is ready when requested
+    void speculate()
+    {
+        if (continuousAnalysis && (!gameOver()) && (!game.firstClick()))
+            speculation.start(game.getPosition(), AI);
+        else
+            speculation.cancel();
+    }
+
     bool OnUserUpdate(float fElapsedTime) override
     {
+        TRACE_SCOPE("frame");
         runTime += fElapsedTime;
 
         if (ai_thread_spawned && !ai_thread_working)
         {
             ai_thread.join();
             ai_thread_spawned = false;
+            if (ai_job == AIJob::MOVE_EXECUTE)
+                speculate();
         }
             
         if ((GetMouse(0).bReleased))
@@ -546,6 +612,8 @@ public:
                     cyan_drawTime = 0.5f;
                     game.click(std::get<0>(fieldCoord), std::get<1>(fieldCoord));
                     AI.sortKnowledge();
+                    speculate();
+                    publisher.publish(&game, AI);
                 }
             }
         }
@@ -554,15 +622,40 @@ public:
             //Handle the player toggling a flag
             std::tuple<int, int> fieldCoord = ScreenToCell(GetMouseX(), GetMouseY());
             if (fieldCoord != std::tuple<int, int>(-1, -1))
+            {
                 game.toggleFlag(std::get<0>(fieldCoord), std::get<1>(fieldCoord));
+                speculate();
+            }
         }
         else if ((GetKey(olc::Key::SPACE).bPressed) && (!ai_thread_spawned))
         {
             gameTime = 0.0f;
+            speculation.clear();
             game.resetGame();
         }
+        else if ((GetKey(olc::Key::C).bPressed) && (!ai_thread_spawned))
+        {
+            continuousAnalysis = !continuousAnalysis;
+            speculate();
+        }
+        else if ((GetKey(olc::Key::P).bPressed) && (!ai_thread_spawned))
+        {
+            if (publisher.isOpen())
+            {
+                AI.publisher = nullptr;
+                publisher.close();
+            }
+            else if (publisher.open("CppSweeper", 1 << 16))
+            {
+                AI.publisher = &publisher;
+                publisher.publish(&game, AI);
+            }
+        }
         else if ((GetKey(olc::Key::V).bPressed) && (!ai_thread_spawned))
+        {
             AI.rotate = !AI.rotate;
+            speculate();
+        }
         else if ((GetKey(olc::Key::Z).bPressed) && (!ai_thread_spawned))
             game.firstClick_zeroNeighbours = !game.firstClick_zeroNeighbours;
         else if ((GetKey(olc::Key::M).bHeld) && (!gameOver()) && (!ai_thread_spawned))
@@ -570,7 +663,9 @@ public:
             cyan_current = CYAN_THINKING;
             cyan_drawTime = 0.5f;
             ai_thread_interrupt = false;
+            AI.interrupt = false;
             ai_thread_spawned = true;
+            ai_job = AIJob::MOVE_EXECUTE;
             ai_thread = std::thread(&ConsoleSweeper::AI_thread, this, AIJob::MOVE_EXECUTE);
             AI.sortKnowledge();
         }
@@ -579,7 +674,9 @@ public:
             cyan_current = CYAN_THINKING;
             cyan_drawTime = 0.5f;
             ai_thread_interrupt = false;
+            AI.interrupt = false;
             ai_thread_spawned = true;
+            ai_job = AIJob::MOVE;
             ai_thread = std::thread(&ConsoleSweeper::AI_thread, this, AIJob::MOVE);
         }
         else if ((GetKey(olc::Key::L).bPressed))
@@ -587,8 +684,11 @@ public:
             if (!ai_thread_spawned)
             {
                 ai_thread_interrupt = false;
+                AI.interrupt = false;
                 ai_loop_counter = 10000;
                 ai_thread_spawned = true;
+                ai_job = AIJob::GAMELOOP;
+                speculation.cancel();
                 ai_thread = std::thread(&ConsoleSweeper::AI_thread, this, AIJob::GAMELOOP);
             }
             else
@@ -602,8 +702,11 @@ public:
             if (!ai_thread_spawned)
             {
                 ai_thread_interrupt = false;
+                AI.interrupt = false;
                 ai_loop_counter = 1;
                 ai_thread_spawned = true;
+                ai_job = AIJob::GAME;
+                speculation.cancel();
                 ai_thread = std::thread(&ConsoleSweeper::AI_thread, this, AIJob::GAME);
             }
             else
@@ -625,6 +728,7 @@ public:
             fieldPosX = menuW + borderW + 300;
             fieldPosY = menuH + borderW + 100;
             resetStats();
+            speculation.clear();
             game.width = 9;
             game.height = 9;
             game.mineCount = 10;
@@ -646,6 +750,7 @@ public:
             else
                 fieldPosY = menuH / 2;
             resetStats();
+            speculation.clear();
             game.width = 16;
             game.height = 16;
             game.mineCount = 40;
@@ -667,6 +772,7 @@ public:
             else
                 fieldPosY = menuH / 2;
             resetStats();
+            speculation.clear();
             game.width = 30;
             game.height = 16;
             game.mineCount = 99;
@@ -684,6 +790,7 @@ public:
                 AI.maxSamples += 10000;
             else
                 AI.maxSamples += 1000;
+            speculate();
         }
         else if ((GetKey(olc::Key::NP_SUB).bPressed))
         {
@@ -697,10 +804,17 @@ public:
                 AI.maxSamples -= 10000;
             else if (AI.maxSamples > 1000)
                 AI.maxSamples -= 1000;
+            speculate();
         }
         else if (GetKey(olc::Key::S).bPressed)
         {
             if (AI.stochasticMethod == StochasticMethod::METHOD_BACKTRACKING)
+                AI.stochasticMethod = StochasticMethod::METHOD_EXACT;
+            else if (AI.stochasticMethod == StochasticMethod::METHOD_EXACT)
+                AI.stochasticMethod = StochasticMethod::METHOD_CASCADE;
+            else if (AI.stochasticMethod == StochasticMethod::METHOD_CASCADE)
+                AI.stochasticMethod = StochasticMethod::METHOD_BELIEF;
+            else if (AI.stochasticMethod == StochasticMethod::METHOD_BELIEF)
                 AI.stochasticMethod = StochasticMethod::METHOD_AVGCONSTRAINT;
             else if (AI.stochasticMethod == StochasticMethod::METHOD_AVGCONSTRAINT)
                 AI.stochasticMethod = StochasticMethod::METHOD_SINGLECONSTRAINT;
@@ -709,6 +823,7 @@ public:
             else
                 AI.stochasticMethod = StochasticMethod::METHOD_BACKTRACKING;
             resetStats();
+            speculate();
         }
 
         if (!gameOver())
@@ -768,7 +883,10 @@ public:
             int offset = 15;
 
             DrawString(ScreenWidth() - 200, 5, "DECISIONS", olc::CYAN, 1);
-            while (!m.try_lock());
+            {
+                TRACE_SCOPE("lock wait");
+                while (!m.try_lock());
+            }
             for (auto itr = AImoves.begin(); itr != AImoves.end(); ++itr)
             {
                 switch (itr->moveType)
@@ -809,4 +927,4 @@ int main()
         game.Start();
     }
 
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,4 +1,8 @@
 #include "CppSweeper.h"
+#include "CppSweeperShared.h"
+#include "CppSweeperSpeculation.h"
+#include "CppSweeperTiles.h"
+#include "CppSweeperTrace.h"
 #include <random>
 #include <time.h>
 #include <algorithm>
@@ -7,58 +11,20 @@
 
 std::vector<Cell*> CppSweeper::getNeighbourCells(int x, int y)
 {
-	std::vector<Cell*> neighbours;
-
-	if (x > 0)
-	{
-		neighbours.push_back(&field[coord(x - 1, y)]);
-		if (y > 0)
-			neighbours.push_back(&field[coord(x - 1, y - 1)]);
-		if (y < height - 1)
-			neighbours.push_back(&field[coord(x - 1, y + 1)]);
-	}
-	if (x < width - 1)
-	{
-		neighbours.push_back(&field[coord(x + 1, y)]);
-		if (y > 0)
-			neighbours.push_back(&field[coord(x + 1, y - 1)]);
-		if (y < height - 1)
-			neighbours.push_back(&field[coord(x + 1, y + 1)]);
-	}
-	if (y < height - 1)
-		neighbours.push_back(&field[coord(x, y + 1)]);
-	if (y > 0)
-		neighbours.push_back(&field[coord(x, y - 1)]);
-
-	return neighbours;
+	const int32_t* neighbours = geometry_.neighbours + 8 * coord(x, y);
+	std::vector<Cell*> cells(geometry_.neighbourCount[coord(x, y)]);
+	for (unsigned i = 0; i < cells.size(); i++)
+		cells[i] = &field[neighbours[i]];
+	return cells;
 }
 
 std::vector<VisibleCell*> CppSweeper::getVisibleNeighbourCells(int x, int y)
 {
-	std::vector<VisibleCell*> neighbours;
-
-	if (x > 0)
-	{
-		neighbours.push_back(&visibleField[coord(x - 1, y)]);
-		if (y > 0)
-			neighbours.push_back(&visibleField[coord(x - 1, y - 1)]);
-		if (y < height - 1)
-			neighbours.push_back(&visibleField[coord(x - 1, y + 1)]);
-	}
-	if (x < width - 1)
-	{
-		neighbours.push_back(&visibleField[coord(x + 1, y)]);
-		if (y > 0)
-			neighbours.push_back(&visibleField[coord(x + 1, y - 1)]);
-		if (y < height - 1)
-			neighbours.push_back(&visibleField[coord(x + 1, y + 1)]);
-	}
-	if (y < height - 1)
-		neighbours.push_back(&visibleField[coord(x, y + 1)]);
-	if (y > 0)
-		neighbours.push_back(&visibleField[coord(x, y - 1)]);
-
-	return neighbours;
+	const int32_t* neighbours = geometry_.neighbours + 8 * coord(x, y);
+	std::vector<VisibleCell*> cells(geometry_.neighbourCount[coord(x, y)]);
+	for (unsigned i = 0; i < cells.size(); i++)
+		cells[i] = &visibleField[neighbours[i]];
+	return cells;
 }
 
 VisibleCell* CppSweeper::getCell(int x, int y)
@@ -71,11 +37,21 @@ VisibleCell* CppSweeper::getCell(std::tuple<int, int> coord)
 	return &visibleField[coord(std::get<0>(coord), std::get<1>(coord))];
 }
 
+bool CppSweeper::moveLeft()
+{
+	for (int i = 0; i < width * height; i++)
+		if ((!visibleField[i].clicked) && (!visibleField[i].knownMine))
+			return true;
+	return false;
+}
+
 bool CppSweeper::click(int x, int y)
 {
 	if (gameLost_ || gameWon_ || (x >= width) || (x < 0) || (y >= height) || (y < 0) ||
 		field[coord(x, y)].flag || field[coord(x, y)].clicked)
 		return false;
+	if (!uncovering_)
+		replay_.moves.push_back(ReplayMove{ x, y, false });
 	
 	if (firstClick_)
 	{
@@ -131,6 +107,10 @@ bool CppSweeper::click(int x, int y)
 
 void CppSweeper::toggleFlag(int x, int y)
 {
+	if ((x >= width) || (x < 0) || (y >= height) || (y < 0))
+		return;
+	if ((flagCount_ > 0) || field[coord(x, y)].flag)
+		replay_.moves.push_back(ReplayMove{ x, y, true });
 	if ((flagCount_ > 0) && (!field[coord(x, y)].flag))
 	{
 		field[coord(x, y)].flag = true;
@@ -147,6 +127,8 @@ void CppSweeper::toggleFlag(int x, int y)
 
 void CppSweeper::uncoverNeighbours(int x, int y)
 {
+	bool uncovering = uncovering_;
+	uncovering_ = true;
 	for (unsigned i = 0; i < field[coord(x, y)].neighbouringCells.size(); i++)
 	{
 		std::vector<Cell*> neighbours = field[coord(x, y)].neighbouringCells;
@@ -155,6 +137,7 @@ void CppSweeper::uncoverNeighbours(int x, int y)
 		if (!field[coord(neighbourX, neighbourY)].clicked)
 			click(neighbourX, neighbourY);
 	}
+	uncovering_ = uncovering;
 }
 
 void CppSweeper::generateField(int safeX, int safeY)
@@ -165,6 +148,8 @@ void CppSweeper::generateField(int safeX, int safeY)
 		mineCount = std::min(mineCount, width * height - 1);
 	int minesToGenerate = mineCount;
 	int x, y;
+	replayable_ = seedFresh_;
+	seedFresh_ = false;
 
 	while (minesToGenerate > 0)
 	{
@@ -194,31 +179,56 @@ void CppSweeper::generateField(int safeX, int safeY)
 		}
 	}
 
-	//Update the field and visibleField data
-	for (int x = 0; x < width; x++)
-		for (int y = 0; y < height; y++)
-		{
-			field[coord(x, y)].neighbouringCells = getNeighbourCells(x, y);
-			visibleField[coord(x, y)].neighbouringCells = getVisibleNeighbourCells(x, y);
+	linkCells();
+}
 
-			std::vector<Cell*> neighbours = field[coord(x, y)].neighbouringCells;
-			int mc = 0;
-			for (unsigned i = 0; i < neighbours.size(); i++)
-				if (neighbours.at(i)->mine)
-					mc++;
-			field[coord(x, y)].neighbouringMines = mc;
+//Sets up the neighbour lists of field and visibleField and the true count of neighbouring mines of each cell
+void CppSweeper::linkCells()
+{
+	for (int i = 0; i < width * height; i++)
+	{
+		const int32_t* neighbours = geometry_.neighbours + 8 * i;
+		int count = geometry_.neighbourCount[i];
+		field[i].neighbouringCells.resize(count);
+		visibleField[i].neighbouringCells.resize(count);
+		int mc = 0;
+		for (int n = 0; n < count; n++)
+		{
+			field[i].neighbouringCells[n] = &field[neighbours[n]];
+			visibleField[i].neighbouringCells[n] = &visibleField[neighbours[n]];
+			mc += field[neighbours[n]].mine;
 		}
+		field[i].neighbouringMines = mc;
+	}
 }
 
 void CppSweeper::resetGame()
 {
-	if (field != nullptr) {
-		delete[] field;
-		delete[] visibleField;
+	if ((field != nullptr) && (width == geometry_.width) && (height == geometry_.height))
+	{
+		//Same size: reset the cells in place and keep their neighbour lists, which are still valid
+		for (int i = 0; i < width * height; i++)
+		{
+			std::vector<Cell*> neighbours;
+			std::vector<VisibleCell*> visibleNeighbours;
+			neighbours.swap(field[i].neighbouringCells);
+			visibleNeighbours.swap(visibleField[i].neighbouringCells);
+			field[i] = Cell();
+			visibleField[i] = VisibleCell();
+			field[i].neighbouringCells.swap(neighbours);
+			visibleField[i].neighbouringCells.swap(visibleNeighbours);
+		}
+	}
+	else
+	{
+		if (field != nullptr) {
+			delete[] field;
+			delete[] visibleField;
+		}
+		geometry_.setSize(width, height);
+		field = new Cell[width * height];
+		visibleField = new VisibleCell[width * height];
 	}
-
-	field = new Cell[width * height];
-	visibleField = new VisibleCell[width * height];
 	for (int x = 0; x < width; x++)
 		for (int y = 0; y < height; y++)
 		{
@@ -235,6 +245,8 @@ void CppSweeper::resetGame()
 	firstClick_ = true;
 	uncoveredCells_ = 0;
 	flagCount_ = mineCount;
+	replay_.moves.clear();
+	replayable_ = false;
 
 	if ((AI != NULL))
 	{
@@ -247,14 +259,112 @@ void CppSweeper::resetGame()
 
 CppSweeper::CppSweeper()
 {
-	srand(static_cast<unsigned int>(time(nullptr)));
-	generator.seed(static_cast<unsigned int>(time(nullptr)));
+	seed(static_cast<unsigned int>(time(nullptr)));
+	resetGame();
+}
+
+void CppSweeper::seed(unsigned int seed)
+{
+	srand(seed);
+	generator.seed(seed);
+	replay_.seed = seed;
+	seedFresh_ = true;
+}
+
+//Returns the current position as seen by the player; the mine layout is included once the field has been generated
+SweeperPosition CppSweeper::getPosition()
+{
+	SweeperPosition position;
+	position.width = width;
+	position.height = height;
+	position.mineCount = mineCount;
+	position.cells.assign(width * height, SweeperPosition::COVERED);
+	if (!firstClick_)
+		position.mines.assign(width * height, false);
+
+	for (int x = 0; x < width; x++)
+		for (int y = 0; y < height; y++)
+		{
+			if (visibleField[coord(x, y)].clicked)
+				position.cells[coord(x, y)] = visibleField[coord(x, y)].neighbouringMines;
+			else if (visibleField[coord(x, y)].flag)
+				position.cells[coord(x, y)] = SweeperPosition::FLAGGED;
+			if (!firstClick_)
+				position.mines[coord(x, y)] = field[coord(x, y)].mine;
+		}
+	return position;
+}
+
+//Sets up the game in the given position. The revealed cells are clicked in column-major order, so that the engine shadows them
+//through updateKnowledge. If the position carries no mine layout, the revealed numbers are taken from the position.
+void CppSweeper::loadPosition(const SweeperPosition& position)
+{
+	width = position.width;
+	height = position.height;
+	mineCount = position.mineCount;
+	resetGame();
+
+	if (position.mines.size() > 0)
+		for (int i = 0; i < width * height; i++)
+			field[i].mine = position.mines[i];
+	linkCells();
+	firstClick_ = false;
+
+	for (int x = 0; x < width; x++)
+		for (int y = 0; y < height; y++)
+		{
+			signed char value = position.cells[coord(x, y)];
+			if (value == SweeperPosition::FLAGGED)
+				toggleFlag(x, y);
+			else if (value != SweeperPosition::COVERED)
+			{
+				lastClicked = std::tuple<int, int>(x, y);
+				field[coord(x, y)].clicked = true;
+				field[coord(x, y)].neighbouringMines = value;
+				visibleField[coord(x, y)].clicked = true;
+				visibleField[coord(x, y)].neighbouringMines = value;
+				uncoveredCells_++;
+				if (AI != NULL)
+					AI->updateKnowledge(this, x, y);
+			}
+		}
+}
+
+//Copies the moves of the current game into replay. Returns false if the game cannot be reproduced from a seed,
+//i.e. if its field was not generated right after a call of seed, or if it was set up by loadPosition
+bool CppSweeper::getReplay(SweeperReplay* replay)
+{
+	if (!replayable_)
+		return false;
+	*replay = replay_;
+	replay->width = width;
+	replay->height = height;
+	replay->mineCount = mineCount;
+	replay->zeroNeighbourStart = firstClick_zeroNeighbours;
+	return true;
+}
+
+void CppSweeper::playReplay(const SweeperReplay& replay)
+{
+	width = replay.width;
+	height = replay.height;
+	mineCount = replay.mineCount;
+	firstClick_zeroNeighbours = replay.zeroNeighbourStart;
+	seed(replay.seed);
 	resetGame();
+	for (auto itr = replay.moves.begin(); itr != replay.moves.end(); itr++)
+	{
+		if (itr->flag)
+			toggleFlag(itr->x, itr->y);
+		else
+			click(itr->x, itr->y);
+	}
 }
 
 CppSweeper::~CppSweeper()
 {
 	delete[] field;
+	delete[] visibleField;
 }
 
 //O(n*m) check it cells1 is contained in cells2
@@ -277,12 +387,20 @@ void CppSweeper_AI::sortKnowledge()
 //Assumes that x and y have been clicked last and hence updates the knowledge-variable. This method is called by CppSweeper::click()
 void CppSweeper_AI::updateKnowledge(CppSweeper* game, int x, int y)
 {
-	while (!m->try_lock());
+	TRACE_SCOPE("knowledge update");
+	PhaseTimer timer(pendingKnowledgeTime_);
+	{
+		TRACE_SCOPE("lock wait");
+		while (!m->try_lock());
+	}
 	VisibleCell* cell = game->getCell(x, y);
 	if ((cell->clicked) && (!cell->mine))
 	{
 		cell->mineProbability = 0.0f;
+		revealedCells.push_back(cell);
 		std::vector<KnowledgeDatum*> updatedKnowledge;
+		//updatedKnowledge points into knowledge, which must therefore not reallocate when kd is added below
+		knowledge.reserve(knowledge.size() + 1);
 
 		//The clicked cell is not a mine, hence all entries of knowledge can be reduced by this cell
 		for (auto it = knowledge.begin(); it != knowledge.end(); it++)
@@ -553,6 +671,7 @@ std::tuple<int, int> CppSweeper_AI::stochasticMove_averageConstraint(CppSweeper*
 //Check whether mine & simMine settings are consistent with the passed boundary
 bool CppSweeper_AI::checkConstraints(std::vector<VisibleCell*>* boundary)
 {
+	stats_.constraintChecks++;
 	for (auto itr = boundary->begin(); itr != boundary->end(); itr++)
 	{
 		//Count the neighbouring mines and simulated mines
@@ -570,6 +689,7 @@ bool CppSweeper_AI::checkConstraints(std::vector<VisibleCell*>* boundary)
 the sum of set flags and simulated mines surrounding each cell equals cell->neighbouringMines*/
 bool CppSweeper_AI::checkLocalUpperConstraints(VisibleCell* cellToSet)
 {
+	stats_.constraintChecks++;
 	//itr iterates through the neighbouring cells that impose a constraint, i.e. the boundary of cellToSet
 	for (auto itr = (cellToSet)->neighbouringCells.begin(); itr != (cellToSet)->neighbouringCells.end(); itr++)
 	{
@@ -625,6 +745,9 @@ void CppSweeper_AI::label(CppSweeper* game, std::vector<VisibleCell*>* cellsToSe
 int CppSweeper_AI::labelConnectedComponents(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet, std::vector<VisibleCell*>* boundary)
 {
 	components.clear();
+	int count = tiles(game);
+	if (count > 1)
+		return labelTiledComponents(game, cellsToSet, count);
 	int curLabel = 0;
 	for (auto itr = cellsToSet->begin(); itr != cellsToSet->end(); itr++)
 	{
@@ -643,6 +766,83 @@ int CppSweeper_AI::labelConnectedComponents(CppSweeper* game, std::vector<Visibl
 	return curLabel;
 }
 
+static int findRoot(std::vector<int>& parent, int position)
+{
+	while (parent[position] != position)
+	{
+		parent[position] = parent[parent[position]];
+		position = parent[position];
+	}
+	return position;
+}
+
+static void unite(std::vector<int>& parent, int a, int b)
+{
+	a = findRoot(parent, a);
+	b = findRoot(parent, b);
+	if (a != b)
+		parent[std::max(a, b)] = std::min(a, b);
+}
+
+//Labels the connected components of a tiled board without recursion. Each tile joins its constrained cells with the clicked
+//cells next to them in a union-find over the board positions, which stays within the tile's own positions; the pairs that
+//cross a seam between tiles are joined afterwards. The components are then numbered in the order of cellsToSet.
+int CppSweeper_AI::labelTiledComponents(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet, int tiles)
+{
+	int width = game->width;
+	tileParent.resize((size_t)width * game->height);
+	tileLabel.resize((size_t)width * game->height, -1);
+	BoardTiles columns(width, tiles);
+	std::vector<std::vector<std::pair<int, int>>> seams(tiles);
+	runTiles(tiles, [&](int tile) {
+		int begin = columns.begin(tile), end = columns.end(tile);
+		for (int x = begin; x < end; x++)
+			for (int y = 0; y < game->height; y++)
+				tileParent[x + y * width] = x + y * width;
+		for (int x = begin; x < end; x++)
+			for (int y = 0; y < game->height; y++)
+			{
+				VisibleCell* cell = game->getCell(x, y);
+				if (!cell->isConstrained)
+					continue;
+				for (auto itr = cell->neighbouringCells.begin(); itr != cell->neighbouringCells.end(); itr++)
+					if (((*itr)->clicked) && (!(*itr)->isConstrained))
+					{
+						if (((*itr)->x >= begin) && ((*itr)->x < end))
+							unite(tileParent, x + y * width, (*itr)->x + (*itr)->y * width);
+						else
+							seams[tile].push_back(std::make_pair(x + y * width, (*itr)->x + (*itr)->y * width));
+					}
+			}
+	});
+	for (auto tile = seams.begin(); tile != seams.end(); tile++)
+		for (auto itr = tile->begin(); itr != tile->end(); itr++)
+			unite(tileParent, itr->first, itr->second);
+
+	for (auto itr = cellsToSet->begin(); itr != cellsToSet->end(); itr++)
+	{
+		int& label = tileLabel[findRoot(tileParent, (*itr)->x + (*itr)->y * width)];
+		if (label == -1)
+		{
+			label = (int)components.size();
+			components.push_back(ConnectedComponent());
+			components.back().label = label;
+		}
+		(*itr)->connectedComponent = label;
+		components[label].cellsToSet.push_back(*itr);
+	}
+	for (auto itr = cellsToSet->begin(); itr != cellsToSet->end(); itr++)
+		for (auto neighbour = (*itr)->neighbouringCells.begin(); neighbour != (*itr)->neighbouringCells.end(); neighbour++)
+			if (((*neighbour)->clicked) && (!(*neighbour)->isConstrained) && ((*neighbour)->connectedComponent == -1))
+			{
+				(*neighbour)->connectedComponent = (*itr)->connectedComponent;
+				components[(*itr)->connectedComponent].boundary.push_back(*neighbour);
+			}
+	for (auto itr = cellsToSet->begin(); itr != cellsToSet->end(); itr++)
+		tileLabel[findRoot(tileParent, (*itr)->x + (*itr)->y * width)] = -1;
+	return (int)components.size();
+}
+
 void CppSweeper_AI::setProbabilitiesFromSamples(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet)
 {
 	int remainingMines = game->mineCount - knownMines;
@@ -677,6 +877,8 @@ int CppSweeper_AI::nChoosek(int n, int k)
 {
 	if (k > n)
 		return 0;
+	if (n <= BinomialTable::MAX_N)
+		return (int)binomialTable.values[n][k];
 	if (k * 2 > n)
 		k = n - k;
 	if (k == 0)
@@ -692,18 +894,34 @@ int CppSweeper_AI::nChoosek(int n, int k)
 
 void CppSweeper_AI::boundaryBacktracking(CppSweeper* game, std::vector<VisibleCell*>* boundary, std::vector<VisibleCell*>* cellsToSet, std::vector<VisibleCell*>::iterator cellToSet, int remainingMines)
 {
-	if ((remainingMines < 0) || (this->samplesCurrentCycle_ >= maxSamples_) || (cellToSet == cellsToSet->end()) || interrupt)
+	if ((remainingMines < 0) || (this->samplesCurrentCycle_ >= maxSamples_) || (this->nodesCurrentCycle_ >= maxSamples_ * searchNodesPerSample) ||
+		(cellToSet == cellsToSet->end()) || interrupt.load(std::memory_order_relaxed))
 		return;
 
+	stats_.searchNodes++;
+	this->nodesCurrentCycle_++;
 	if (this->samplesCurrentCycle_ % 100000 == 0)
 		setProbabilitiesFromSamples(game, cellsToSet);
 
-	(*cellToSet)->simMine = true;
 	VisibleCell* cell = (*cellToSet);
 
-	if ((cellToSet == cellsToSet->end() - 1) || (remainingMines == 1))
+	//Cells whose value follows from a reduced row of the frontier system (cf. gaussianDeduction) are not branched on
+	bool tryMine = true;
+	bool trySafe = true;
+	if (cell->forcedRow != -1)
+	{
+		int forced = forcedValue(cell);
+		tryMine = (forced == 1);
+		trySafe = (forced == 0);
+		if (!tryMine || !trySafe)
+			stats_.prunedBranches++;
+	}
+
+	(*cellToSet)->simMine = true;
+	if ((tryMine) && ((cellToSet == cellsToSet->end() - 1) || (remainingMines == 1)))
 	{
 		this->samplesCurrentCycle_++;
+		stats_.leaves++;
 		int nk = 0;
 		if ((remainingMines > 1) && (unconstrainedCells <= 25))
 			nk = nChoosek(unconstrainedCells, remainingMines - 1) - 1;
@@ -712,6 +930,7 @@ void CppSweeper_AI::boundaryBacktracking(CppSweeper* game, std::vector<VisibleCe
 		if ((validConfiguration))
 		{
 			this->components[(*cellToSet)->connectedComponent].validSamples += 1 + nk;
+			this->components[(*cellToSet)->connectedComponent].validLeaves++;
 			for (auto itr = cellsToSet->begin(); itr != cellsToSet->end(); itr++)
 				if ((*itr)->simMine) {
 					(*itr)->validSimMines++;
@@ -721,14 +940,17 @@ void CppSweeper_AI::boundaryBacktracking(CppSweeper* game, std::vector<VisibleCe
 		}
 
 	}
-	else if (checkLocalUpperConstraints(cell))
+	else if ((tryMine) && (checkLocalUpperConstraints(cell)))
 		boundaryBacktracking(game, boundary, cellsToSet, (cellToSet)+1, remainingMines - 1);
+	else if (tryMine)
+		stats_.prunedBranches++;
 
 
 	(*cellToSet)->simMine = false;
-	if ((cellToSet == cellsToSet->end() - 1) || (remainingMines == 0))
+	if ((trySafe) && ((cellToSet == cellsToSet->end() - 1) || (remainingMines == 0)))
 	{
 		this->samplesCurrentCycle_++;
+		stats_.leaves++;
 
 		int nk = 0;
 		if ((remainingMines > 0) && (unconstrainedCells <= 25))
@@ -738,6 +960,7 @@ void CppSweeper_AI::boundaryBacktracking(CppSweeper* game, std::vector<VisibleCe
 		if ((validConfiguration))
 		{
 			this->components[(*cellToSet)->connectedComponent].validSamples += 1 + nk;
+			this->components[(*cellToSet)->connectedComponent].validLeaves++;
 			for (auto itr = cellsToSet->begin(); itr != cellsToSet->end(); itr++)
 				if ((*itr)->simMine)
 				{
@@ -747,76 +970,201 @@ void CppSweeper_AI::boundaryBacktracking(CppSweeper* game, std::vector<VisibleCe
 		}
 
 	}
-	else
+	else if (trySafe)
 		boundaryBacktracking(game, boundary, cellsToSet, cellToSet + 1, remainingMines);
 }
 
-//Probability = #(simulations where the cell is a mine) / #(total valid simulations), i.e. the algorithm samples the configuration space of constrained cells.
-//The algorithm returns the cell with the minimum probability
-//Important note: The algorithm assumes that flags have been set at cells that are known with certainty to be mines; It assumes that the remaining flags equate the remaining mines.
-std::tuple<int, int> CppSweeper_AI::stochasticMove_BoundaryBacktracking(CppSweeper* game)
+//Amount by which the default mine probability of a cell is lowered: a positive bias for corner cells, a smaller one for edge
+//cells, which are more likely to open an area
+double CppSweeper_AI::edgeBias(CppSweeper* game, int x, int y)
+{
+	bool xEdge = (x == 0) || (x == game->width - 1);
+	bool yEdge = (y == 0) || (y == game->height - 1);
+	if (xEdge && yEdge)
+		return 0.001f;
+	else if (xEdge || yEdge)
+		return 0.0001f;
+	return 0.0;
+}
+
+//Resets the values used by the stochastic engine, sets default mine probabilities and collects the boundary (the constraint imposing
+//clicked cells) and the constrained cells that are not known to be mines. On a tiled board each tile collects the cells of its
+//columns, and the lists are joined in column order, as without tiles.
+void CppSweeper_AI::collectBoundary(CppSweeper* game, std::vector<VisibleCell*>* boundary, std::vector<VisibleCell*>* cellsToSet)
 {
 	int remainingMines = game->mineCount - knownMines;
 	double defaultProbability = ((double)remainingMines) / (double)((game->width * game->height - knownMines - game->uncoveredCells()));
+	int count = tiles(game);
+	BoardTiles columns(game->width, count);
+	std::vector<std::vector<VisibleCell*>> tileBoundary(count - 1);
+	std::vector<std::vector<VisibleCell*>> tileCells(count - 1);
+
+	runTiles(count, [&](int tile) {
+		std::vector<VisibleCell*>* boundaryOut = (tile == 0) ? boundary : &tileBoundary[tile - 1];
+		std::vector<VisibleCell*>* cellsOut = (tile == 0) ? cellsToSet : &tileCells[tile - 1];
+		//Set default values and build up the boundary and constrained cells
+		for (int x = columns.begin(tile); x < columns.end(tile); x++)
+			for (int y = 0; y < game->height; y++)
+			{
+				auto cell = game->getCell(x, y);
+				cell->connectedComponent = -1;
+				cell->simMine = 0;
+				cell->validSimMines = 0;
+				cell->isConstrained = false;
+				bool isBdry = false;
+				bool isConstrained = false;
+
+				//Check whether a clicked cell is part of the boundary
+				if ((cell->clicked))
+				{
+					for (auto itr = cell->neighbouringCells.begin(); itr != cell->neighbouringCells.end(); itr++)
+						if ((!(*itr)->clicked) && (!(*itr)->flag))
+						{
+							isBdry = true;
+							break;
+						}
+					if (isBdry)
+						boundaryOut->push_back(cell);
+				}
+				//Check whether an unclicked cell (that is not known to be a mine already) is constrained
+				else if (cell->mineProbability < 1.0f)
+				{
+					for (auto itr = cell->neighbouringCells.begin(); itr != cell->neighbouringCells.end(); itr++)
+						if ((*itr)->clicked)
+						{
+							isConstrained = true;
+							break;
+						}
+					if (isConstrained)
+					{
+						cellsOut->push_back(cell);
+						cell->isConstrained = true;
+					}
 
-	//The constraint imposing cells
-	std::vector<VisibleCell*> boundary; 
-	//the constrained cells along the boundary, to be probed
-	std::vector<VisibleCell*> cellsToSet; 
+					/*Set default mine probabilities*/
+					cell->mineProbability = defaultProbability - edgeBias(game, x, y);
+				}
+			}
+	});
+	for (int tile = 1; tile < count; tile++)
+	{
+		boundary->insert(boundary->end(), tileBoundary[tile - 1].begin(), tileBoundary[tile - 1].end());
+		cellsToSet->insert(cellsToSet->end(), tileCells[tile - 1].begin(), tileCells[tile - 1].end());
+	}
+}
 
-	//Set default values and build up the boundary and constrained cells
-	for (int x = 0; x < game->width; x++)
-		for (int y = 0; y < game->height; y++)
-		{
-			auto cell = game->getCell(x, y);
-			cell->connectedComponent = -1;
-			cell->simMine = 0;
-			cell->validSimMines = 0;
-			cell->isConstrained = false;
-			bool isBdry = false;
-			bool isConstrained = false;
+//Returns the number of tiles the passes over the board split it into, creating the worker pool if needed
+int CppSweeper_AI::tiles(CppSweeper* game)
+{
+	if ((tileThreads <= 1) || ((long long)game->width * game->height < tileMinCells))
+		return 1;
+	if (!tilePool)
+		tilePool = std::make_shared<TilePool>(tileThreads);
+	//Several tiles per thread even out their loads; a tile is at least three columns wide, so that the halo of a cell's
+	//neighbours never reaches beyond the adjacent tiles
+	return std::max(1, std::min(tilePool->threads() * 4, game->width / 3));
+}
+
+void CppSweeper_AI::runTiles(int tiles, const std::function<void(int)>& pass)
+{
+	if (tiles == 1)
+		pass(0);
+	else
+		tilePool->run(tiles, pass);
+}
 
-			//Check whether a clicked cell is part of the boundary
-			if ((cell->clicked))
+//Performs the backtracking search on a component to estimate the mine probabilities of its cells. With rotate, the search is
+//repeated with each cell at the front; if target is not negative, the passes stop early once the component's samples settle
+//how its cells compare to a cell of probability target (cf. samplingSettled).
+void CppSweeper_AI::sampleComponent(CppSweeper* game, ConnectedComponent* component, double target)
+{
+	unconstrainedCells = game->width * game->height - game->uncoveredCells() - component->cellsToSet.size() - (game->mineCount - game->flagCount());
+	if (component->cellsToSet.size() == 0)
+		return;
+	TRACE_SCOPE_ARG("component search", (int)component->cellsToSet.size());
+	//Order the free variables of the reduced frontier system first, so that the pivot cells are determined once they are reached
+	std::stable_partition(component->cellsToSet.begin(), component->cellsToSet.end(), [this](VisibleCell* cell) {
+		int column = (reduction.columnOf.size() > 0) ? reduction.columnOf[cell->x + cell->y * reduction.width] : -1;
+		return (column == -1) || (!reduction.isPivot[column]); });
+
+	//rotate==true: Perform a backtracking search with each cell at the front exactly one time
+	if (rotate)
+	{
+		this->maxSamples_ = maxSamples / component->cellsToSet.size();
+		for (unsigned j = 0; j < component->cellsToSet.size() - 1; j++)
+		{
+			TRACE_SCOPE_ARG("rotation pass", (int)j);
+			samplesCurrentCycle_ = 0;
+			nodesCurrentCycle_ = 0;
+			prepareForcedCells(&component->cellsToSet);
 			{
-				for (auto itr = cell->neighbouringCells.begin(); itr != cell->neighbouringCells.end(); itr++)
-					if ((!(*itr)->clicked) && (!(*itr)->flag))
-					{
-						isBdry = true;
-						break;
-					}		
-				if (isBdry)
-					boundary.push_back(cell);
+				PhaseTimer timer(stats_.searchTime);
+				boundaryBacktracking(game, &component->boundary, &component->cellsToSet, component->cellsToSet.begin(), game->flagCount());
 			}
-			//Check whether an unclicked cell (that is not known to be a mine already) is constrained
-			else if (cell->mineProbability < 1.0f)
+			for (int x = 0; x < game->width; x++)
+				for (int y = 0; y < game->height; y++)
+					game->getCell(x, y)->simMine = false;
+			totalSamples_ += samplesCurrentCycle_;
+			std::rotate(component->cellsToSet.begin(), component->cellsToSet.begin() + 1, component->cellsToSet.end());
 			{
-				for (auto itr = cell->neighbouringCells.begin(); itr != cell->neighbouringCells.end(); itr++)
-					if ((*itr)->clicked)
-					{
-						isConstrained = true;
-						break;
-					}
-				if (isConstrained)
-				{
-					cellsToSet.push_back(cell);
-					cell->isConstrained = true;
-				}
-
-				/*Set default mine probabilities*/
-				//positive bias for corner cells
-				if ((x == game->width - 1) && (y == game->height - 1) || ((x == game->width - 1) && (y == 0)) || ((x == 0) && (y == game->height - 1)) || ((x == 0) && (y == 0)))
-					cell->mineProbability = defaultProbability - 0.001f;
-				//less positive bias for edge cells
-				else if ((x == game->width - 1) || (x == 0) || (y == game->height - 1) || (y == 0))
-					cell->mineProbability = defaultProbability - 0.0001f;
-				else
-					cell->mineProbability = defaultProbability;
+				PhaseTimer timer(stats_.probabilityTime);
+				setProbabilitiesFromSamples(game, &component->cellsToSet);
 			}
-				
+			if ((target >= 0.0) && samplingSettled(component, target))
+				break;
 		}
+	}
+	else
+	{
+		this->maxSamples_ = maxSamples;
+		samplesCurrentCycle_ = 0;
+		nodesCurrentCycle_ = 0;
+		prepareForcedCells(&component->cellsToSet);
+		{
+			PhaseTimer timer(stats_.searchTime);
+			boundaryBacktracking(game, &component->boundary, &component->cellsToSet, component->cellsToSet.begin(), game->flagCount());
+		}
+		for (int x = 0; x < game->width; x++)
+			for (int y = 0; y < game->height; y++)
+				game->getCell(x, y)->simMine = false;
+		{
+			PhaseTimer timer(stats_.probabilityTime);
+			setProbabilitiesFromSamples(game, &component->cellsToSet);
+		}
+	}
+}
+
+void CppSweeper_AI::Stages::prepareSearch(CppSweeper* game, ConnectedComponent& component, long long maxSamples)
+{
+	engine_.unconstrainedCells = game->width * game->height - game->uncoveredCells() - (int)component.cellsToSet.size() - (game->mineCount - game->flagCount());
+	engine_.maxSamples_ = maxSamples;
+	engine_.samplesCurrentCycle_ = 0;
+	engine_.nodesCurrentCycle_ = 0;
+	engine_.prepareForcedCells(&component.cellsToSet);
+}
 
-	int componentCount = labelConnectedComponents(game, &cellsToSet, &boundary);
+long long CppSweeper_AI::Stages::search(CppSweeper* game, ConnectedComponent& component)
+{
+	engine_.boundaryBacktracking(game, &component.boundary, &component.cellsToSet, component.cellsToSet.begin(), game->flagCount());
+	return engine_.samplesCurrentCycle_;
+}
+
+//Probability = #(simulations where the cell is a mine) / #(total valid simulations), i.e. the algorithm samples the configuration space of constrained cells.
+//The algorithm returns the cell with the minimum probability
+//Important note: The algorithm assumes that flags have been set at cells that are known with certainty to be mines; It assumes that the remaining flags equate the remaining mines.
+std::tuple<int, int> CppSweeper_AI::stochasticMove_BoundaryBacktracking(CppSweeper* game)
+{
+	//The constraint imposing cells
+	std::vector<VisibleCell*> boundary; 
+	//the constrained cells along the boundary, to be probed
+	std::vector<VisibleCell*> cellsToSet; 
+
+	{
+		TRACE_SCOPE("label components");
+		PhaseTimer timer(stats_.labelTime);
+		collectBoundary(game, &boundary, &cellsToSet);
+		labelConnectedComponents(game, &cellsToSet, &boundary);
+	}
 	samplesCurrentCycle_ = 0;
 	totalSamples_ = 0;
 	_minProbX = -1;
@@ -825,46 +1173,51 @@ std::tuple<int, int> CppSweeper_AI::stochasticMove_BoundaryBacktracking(CppSweep
 	//Sort connected components by size
 	std::sort(components.begin(), components.end(),
 		[](const ConnectedComponent& component1, const ConnectedComponent& component2) { return (component1.cellsToSet.size() < component2.cellsToSet.size()); });
-	for (unsigned i = 0; i < components.size(); i++)
+	stats_.components = (int)components.size();
+	stats_.constrainedCells = (int)cellsToSet.size();
+	if (components.size() > 0)
+		stats_.largestComponent = (int)components.back().cellsToSet.size();
+
+	//Small components are solved exactly (cf. solveComponent), which is faster than sampling them and has no sampling error
+	if ((components.size() > 0) && (stats_.largestComponent <= exactFastPathCells))
 	{
-		//For each connected component, perform backtracking search along the boundary to estimate mine probabilities
-		unconstrainedCells = game->width * game->height - game->uncoveredCells() - components.at(i).cellsToSet.size() - (game->mineCount - game->flagCount());
-		if (components.at(i).cellsToSet.size() > 0)
+		std::vector<ComponentSolution> solutions(components.size());
+		bool solved = true;
 		{
-			//rotate==true: Perform a backtracking search with each cell at the front exactly one time
-			if (rotate)
-			{
-				this->maxSamples_ = maxSamples / components.at(i).cellsToSet.size();
-				for (unsigned j = 0; j < components.at(i).cellsToSet.size() - 1; j++)
-				{
-					samplesCurrentCycle_ = 0;
-					boundaryBacktracking(game, &components.at(i).boundary, &components.at(i).cellsToSet, components.at(i).cellsToSet.begin(), game->flagCount());
-					for (int x = 0; x < game->width; x++)
-						for (int y = 0; y < game->height; y++)
-							game->getCell(x, y)->simMine = false;
-					totalSamples_ += samplesCurrentCycle_;
-					std::rotate(components.at(i).cellsToSet.begin(), components.at(i).cellsToSet.begin() + 1, components.at(i).cellsToSet.end());
-					setProbabilitiesFromSamples(game, &components.at(i).cellsToSet);
-				}
-			}
-			else
+			TRACE_SCOPE("exact components");
+			PhaseTimer timer(stats_.searchTime);
+			for (unsigned i = 0; (i < components.size()) && solved; i++)
+				solved = solveComponent(components.at(i), exactMaxNodes, &solutions.at(i));
+		}
+		if (solved)
+		{
+			std::tuple<int, int> move;
 			{
-				this->maxSamples_ = maxSamples;
-				samplesCurrentCycle_ = 0;
-				boundaryBacktracking(game, &components.at(i).boundary, &components.at(i).cellsToSet, components.at(i).cellsToSet.begin(), game->flagCount());
-				for (int x = 0; x < game->width; x++)
-					for (int y = 0; y < game->height; y++)
-						game->getCell(x, y)->simMine = false;
-				setProbabilitiesFromSamples(game, &components.at(i).cellsToSet);
+				PhaseTimer timer(stats_.probabilityTime);
+				combineSolutions(game, &solutions, 0);
+				biasUnconstrainedCells(game);
+				move = getMinimumProbabilityCell(game);
 			}
+			if (move != std::tuple<int, int>(-1, -1))
+				lastMove.probability = game->getCell(move)->mineProbability;
+			_minProbX = -1;
+			_minProbY = -1;
+			return move;
 		}
 	}
+	//For each connected component, perform backtracking search along the boundary to estimate mine probabilities
+	for (unsigned i = 0; i < components.size(); i++)
+		sampleComponent(game, &components.at(i), -1.0);
 
-	setProbabilitiesFromSamples(game, &cellsToSet);
-
-	std::tuple<int, int> move = getMinimumProbabilityCell(game);
+	std::tuple<int, int> move;
+	{
+		PhaseTimer timer(stats_.probabilityTime);
+		setProbabilitiesFromSamples(game, &cellsToSet);
+		move = getMinimumProbabilityCell(game);
+	}
 
-	lastMove.probability = game->getCell(move)->mineProbability;
+	if (move != std::tuple<int, int>(-1, -1))
+		lastMove.probability = game->getCell(move)->mineProbability;
 	_minProbX = -1;
 	_minProbY = -1;
 	return move;
@@ -873,7 +1226,7 @@ std::tuple<int, int> CppSweeper_AI::stochasticMove_BoundaryBacktracking(CppSweep
 //Probability = uniform. The algorithm returns a randomly selected cell (that is not known to be a mine).
 std::tuple<int, int> CppSweeper_AI::stochasticMove_random(CppSweeper* game)
 {
-	if (game->gameWon() || game->gameLost())
+	if (game->gameWon() || game->gameLost() || !game->moveLeft())
 		return std::tuple<int, int>(-1, -1);
 	std::tuple<int, int> rndMove = std::tuple<int, int>(rand() % game->width, rand() % game->height);
 	while ((game->getCell(rndMove)->clicked) || (game->getCell(rndMove)->knownMine))
@@ -900,13 +1253,85 @@ std::tuple<int, int> CppSweeper_AI::getMinimumProbabilityCell(CppSweeper* game)
 	return minProbabilityCell;
 }
 
+//Estimates the mine probabilities of the covered cells with the method selected by stochasticMethod and returns the cell
+//of lowest probability
+std::tuple<int, int> CppSweeper_AI::stochasticMove(CppSweeper* game)
+{
+	std::tuple<int, int> move;
+	switch (stochasticMethod)
+	{
+	case StochasticMethod::METHOD_BACKTRACKING:
+	{
+		move = stochasticMove_BoundaryBacktracking(game);
+		if (move == std::tuple<int, int>(-1, -1))
+			move = stochasticMove_averageConstraint(game);
+		break;
+	}
+	case StochasticMethod::METHOD_EXACT:
+	{
+		move = stochasticMove_exact(game);
+		if (move == std::tuple<int, int>(-1, -1))
+			move = stochasticMove_averageConstraint(game);
+		break;
+	}
+	case StochasticMethod::METHOD_CASCADE:
+	{
+		move = stochasticMove_cascade(game);
+		if (move == std::tuple<int, int>(-1, -1))
+			move = stochasticMove_averageConstraint(game);
+		break;
+	}
+	case StochasticMethod::METHOD_BELIEF:
+	{
+		move = stochasticMove_belief(game);
+		if (move == std::tuple<int, int>(-1, -1))
+			move = stochasticMove_averageConstraint(game);
+		break;
+	}
+	case StochasticMethod::METHOD_AVGCONSTRAINT:
+	{
+		move = stochasticMove_averageConstraint(game);
+		break;
+	}
+	case StochasticMethod::METHOD_SINGLECONSTRAINT:
+	{
+		move = stochasticMove_singleConstraint(game);
+		break;
+	}
+	default:
+		move = stochasticMove_random(game);
+	}
+	return move;
+}
+
+//Publishes the state of the engine when a move returns, after its timers have stopped
+class MovePublication
+{
+private:
+	SweeperMapPublisher* publisher_;
+	CppSweeper* game_;
+	CppSweeper_AI& engine_;
+public:
+	MovePublication(SweeperMapPublisher* publisher, CppSweeper* game, CppSweeper_AI& engine) : publisher_(publisher), game_(game), engine_(engine) {}
+	~MovePublication()
+	{
+		if (publisher_ != nullptr)
+			publisher_->publish(game_, engine_);
+	}
+};
+
 //Returns the (x,y) coordinate of a move the engine deems optimal.
 //The engine first attempts to deduce an optimal move using the knowledge it generated via calls of the updateKnowledge-method.
 //If no safe cell can be deduced via this method, a probabilistic estimate is performed to find a move - which one is governed by 
 //the variable stochasticMethod
 std::tuple<int, int> CppSweeper_AI::move(CppSweeper* game)
 {
-	interrupt = false;
+	MovePublication publication(publisher, game, *this);
+	stats_ = AI_Stats();
+	stats_.knowledgeTime = pendingKnowledgeTime_;
+	pendingKnowledgeTime_ = 0.0;
+	TRACE_SCOPE("move");
+	PhaseTimer timer(stats_.totalTime);
 	lastMove.moveNo = game->uncoveredCells() + 1;
 
 	if ((*game).firstClick())
@@ -924,55 +1349,32 @@ std::tuple<int, int> CppSweeper_AI::move(CppSweeper* game)
 	}
 	else
 	{
-		for (auto itr = knowledge.begin(); itr != knowledge.end(); itr++)
-			//Check if a cell is known to be safe
-			if ((itr->neighbouringCells.size() > 0) && (itr->mineCount == 0))
-			{
-				lastMove.moveType = MoveType::MOVE_DETERMINISTIC;
-				moves++;
-				lastMove.x = itr->neighbouringCells.at(0)->x;
-				lastMove.y = itr->neighbouringCells.at(0)->y;
-				components.clear();
-				validSamples_ = 0;
-				//toggle flags and reset values that were used by the stochastic engine
-				for (int x = 0; x < (*game).width; x++)
-					for (int y = 0; y < (*game).height; y++)
-					{
-						auto cell = (*game).getCell(x, y);
-						if (((cell->knownMine) && !cell->flag) || (!(cell->knownMine) && cell->flag))
-							(*game).toggleFlag(x, y);
-						cell->isConstrained = false;
-						cell->connectedComponent = -1;
-					}
-				return std::tuple<int, int>(itr->neighbouringCells.at(0)->x, itr->neighbouringCells.at(0)->y);
-			}
+		//Check if a cell is known to be safe, either directly from knowledge or after running the deduction stages
+		std::tuple<int, int> safeMove;
+		bool safeMoveFound;
+		{
+			TRACE_SCOPE("deduction");
+			PhaseTimer deductionTimer(stats_.deductionTime);
+			patternDeduction(game);
+			safeMoveFound = knownSafeMove(game, safeMove) || ((unitPropagation(game) > 0) && knownSafeMove(game, safeMove)) ||
+				((gaussianDeduction(game) > 0) && knownSafeMove(game, safeMove));
+		}
+		if (safeMoveFound)
+			return safeMove;
 
 		lastMove.moveType = MoveType::MOVE_PROBABILISTIC;
 		guesses++;
 		std::tuple<int, int> rndMove;
-
-		switch (stochasticMethod)
-		{
-		case StochasticMethod::METHOD_BACKTRACKING:
+		double probability;
+		if ((speculation != nullptr) && speculation->answer(game, *this, rndMove, probability))
 		{
-			rndMove = stochasticMove_BoundaryBacktracking(game);
-			if (rndMove == std::tuple<int, int>(-1, -1))
-				rndMove = stochasticMove_averageConstraint(game);
-			break;
-		}
-		case StochasticMethod::METHOD_AVGCONSTRAINT:
-		{
-			rndMove = stochasticMove_averageConstraint(game);
-			break;
-		}
-		case StochasticMethod::METHOD_SINGLECONSTRAINT:
-		{
-			rndMove = stochasticMove_singleConstraint(game);
-			break;
-		}
-		default:
-			rndMove = stochasticMove_random(game);
+			stats_.cacheHits++;
+			lastMove.probability = probability;
+			_minProbX = -1;
+			_minProbY = -1;
 		}
+		else
+			rndMove = stochasticMove(game);
 		toggleFlags(game);
 
 		lastMove.x = std::get<0>(rndMove);
@@ -981,6 +1383,36 @@ std::tuple<int, int> CppSweeper_AI::move(CppSweeper* game)
 	}
 }
 
+//Looks up a cell that knowledge proves to be safe. If one is found, safeMove is set to it, the flags are synchronised
+//with the known mines and the values used by the stochastic engine are reset
+bool CppSweeper_AI::knownSafeMove(CppSweeper* game, std::tuple<int, int>& safeMove)
+{
+	for (auto itr = knowledge.begin(); itr != knowledge.end(); itr++)
+		//Check if a cell is known to be safe
+		if ((itr->neighbouringCells.size() > 0) && (itr->mineCount == 0))
+		{
+			lastMove.moveType = MoveType::MOVE_DETERMINISTIC;
+			moves++;
+			lastMove.x = itr->neighbouringCells.at(0)->x;
+			lastMove.y = itr->neighbouringCells.at(0)->y;
+			components.clear();
+			validSamples_ = 0;
+			//toggle flags and reset values that were used by the stochastic engine
+			for (int x = 0; x < (*game).width; x++)
+				for (int y = 0; y < (*game).height; y++)
+				{
+					auto cell = (*game).getCell(x, y);
+					if (((cell->knownMine) && !cell->flag) || (!(cell->knownMine) && cell->flag))
+						(*game).toggleFlag(x, y);
+					cell->isConstrained = false;
+					cell->connectedComponent = -1;
+				}
+			safeMove = std::tuple<int, int>(itr->neighbouringCells.at(0)->x, itr->neighbouringCells.at(0)->y);
+			return true;
+		}
+	return false;
+}
+
 void CppSweeper_AI::toggleFlags(CppSweeper* game)
 {
 	for (int x = 0; x < (*game).width; x++)
@@ -994,11 +1426,55 @@ void CppSweeper_AI::toggleFlags(CppSweeper* game)
 
 CppSweeper_AI::CppSweeper_AI()
 {
-	
+	m = &defaultMutex;
 }
 
 void CppSweeper_AI::reset()
 {
 	knownMines = 0;
 	knowledge.clear();
+	revealedCells.clear();
+	reduction = GaussianReduction();
+	beliefMessages.clear();
+}
+
+void AI_StatsAggregate::add(const AI_Stats& stats)
+{
+	moves++;
+	int bucket = 0;
+	while ((bucket < BUCKETS - 1) && ((double)(1LL << bucket) < stats.totalTime))
+		bucket++;
+	histogram[bucket]++;
+	maxTime = std::max(maxTime, stats.totalTime);
+
+	totals.knowledgeTime += stats.knowledgeTime;
+	totals.deductionTime += stats.deductionTime;
+	totals.labelTime += stats.labelTime;
+	totals.searchTime += stats.searchTime;
+	totals.probabilityTime += stats.probabilityTime;
+	totals.totalTime += stats.totalTime;
+	totals.searchNodes += stats.searchNodes;
+	totals.prunedBranches += stats.prunedBranches;
+	totals.leaves += stats.leaves;
+	totals.constraintChecks += stats.constraintChecks;
+	totals.cacheHits += stats.cacheHits;
+	totals.patternHits += stats.patternHits;
+	totals.components += stats.components;
+	totals.largestComponent = std::max(totals.largestComponent, stats.largestComponent);
+	totals.constrainedCells += stats.constrainedCells;
+}
+
+double AI_StatsAggregate::percentile(double quantile) const
+{
+	if (moves == 0)
+		return 0.0;
+	long long target = (long long)(quantile * moves);
+	long long count = 0;
+	for (int bucket = 0; bucket < BUCKETS; bucket++)
+	{
+		count += histogram[bucket];
+		if ((count > target) || (count == moves))
+			return (double)(1LL << bucket);
+	}
+	return 0.0;
 }
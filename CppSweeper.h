@@ -3,6 +3,13 @@
 #include <tuple>
 #include <random>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include "CppSweeperGeometry.h"
 
 // O------------------------------------------------------------------------------O
 // | The games internal representation of each cell                               |
@@ -40,6 +47,7 @@ struct VisibleCell
 	bool simMine = false;
 	long long validSimMines = 0;
 	int connectedComponent = -1;
+	int forcedRow = -1;
 };
 
 // O------------------------------------------------------------------------------O
@@ -55,6 +63,51 @@ struct KnowledgeDatum
 	std::vector<VisibleCell*> neighbouringCells;
 };
 
+// O------------------------------------------------------------------------------O
+// | A cardinality constraint used by the propagation engine: exactly mineCount	  |
+// | of the cells (indices into the engine's frontier) are mines.				  |
+// | assignedMines and unassigned are the watched counters, kept up to date as	  |
+// | cells are assigned during propagation and restored when the trail is undone. |
+// O------------------------------------------------------------------------------O
+struct PropagationConstraint
+{
+	std::vector<int> cells;
+	int mineCount = 0;
+	int assignedMines = 0;
+	int unassigned = 0;
+};
+
+// O------------------------------------------------------------------------------O
+// | A row of the frontier constraint matrix used by gaussianDeduction.			  |
+// | Coefficients are restricted to {-1,0,1} and stored as two bitsets over the	  |
+// | columns (positive and negative), packed into 64 bit words so that row		  |
+// | operations process 64 columns at a time.									  |
+// O------------------------------------------------------------------------------O
+struct ConstraintRow
+{
+	std::vector<uint64_t> positive;
+	std::vector<uint64_t> negative;
+	int value = 0;
+};
+
+// O------------------------------------------------------------------------------O
+// | The reduced frontier system and its pivot structure. Column i corresponds	  |
+// | to cells[i]; columnOf maps board coordinates (x+y*width) to columns or -1.	  |
+// | Cells whose column is not a pivot are the free variables of the system.	  |
+// | complete is false if some elimination step had to be skipped because the	  |
+// | resulting coefficient would have left {-1,0,1}.							  |
+// O------------------------------------------------------------------------------O
+struct GaussianReduction
+{
+	std::vector<VisibleCell*> cells;
+	std::vector<int> columnOf;
+	int width = 0;
+	std::vector<ConstraintRow> rows;
+	std::vector<int> pivotColumns;
+	std::vector<bool> isPivot;
+	bool complete = true;
+};
+
 enum class MoveType { MOVE_PROBABILISTIC, MOVE_NOMOVE, MOVE_DETERMINISTIC, MOVE_FIRSTCLICK };
 
 // O------------------------------------------------------------------------------O
@@ -63,11 +116,53 @@ enum class MoveType { MOVE_PROBABILISTIC, MOVE_NOMOVE, MOVE_DETERMINISTIC, MOVE_
 // | METHOD_SINGLECONSTRAINT :		stochasticMove_singleConstraint				  |
 // | METHOD_AVGCONSTRAINT :			stochasticMove_averageConstraint			  |
 // | METHOD_BACKTRACKING			stochasticMove_BoundaryBacktracking			  |
+// | METHOD_EXACT					stochasticMove_exact						  |
+// | METHOD_CASCADE					stochasticMove_cascade						  |
+// | METHOD_BELIEF					stochasticMove_belief						  |
 // O------------------------------------------------------------------------------O
-enum class StochasticMethod { METHOD_RND, METHOD_SINGLECONSTRAINT, METHOD_AVGCONSTRAINT, METHOD_BACKTRACKING };
+enum class StochasticMethod { METHOD_RND, METHOD_SINGLECONSTRAINT, METHOD_AVGCONSTRAINT, METHOD_BACKTRACKING, METHOD_EXACT, METHOD_CASCADE, METHOD_BELIEF };
 
 //Forward declaration
 class CppSweeper;
+class SweeperTablebase;
+class TilePool;
+class SweeperSpeculation;
+class SweeperMapPublisher;
+
+// O------------------------------------------------------------------------------O
+// | A snapshot of a game as seen by the player. cells holds the revealed number  |
+// | (0-8) of each clicked cell, or COVERED/FLAGGED, indexed by x+y*width.		  |
+// | mines holds the true mine layout and is left empty if it is unknown.		  |
+// O------------------------------------------------------------------------------O
+struct SweeperPosition
+{
+	enum : signed char { COVERED = -1, FLAGGED = -2 };
+	int width = 0;
+	int height = 0;
+	int mineCount = 0;
+	std::vector<signed char> cells;
+	std::vector<bool> mines;
+};
+
+// O------------------------------------------------------------------------------O
+// | A game as the seed of the mine generator plus the moves of the player.		  |
+// | Replaying it with CppSweeper::playReplay reproduces the game exactly.		  |
+// O------------------------------------------------------------------------------O
+struct ReplayMove
+{
+	int x, y;
+	bool flag;
+};
+
+struct SweeperReplay
+{
+	int width = 0;
+	int height = 0;
+	int mineCount = 0;
+	bool zeroNeighbourStart = false;
+	unsigned int seed = 0;
+	std::vector<ReplayMove> moves;
+};
 
 // O------------------------------------------------------------------------------O
 // | Representation of the last move of the engine	                              |
@@ -80,6 +175,61 @@ struct AI_Move
 	int x, y;
 };
 
+// O------------------------------------------------------------------------------O
+// | Performance counters of the last call of move. Times are in microseconds.	  |
+// | knowledgeTime covers the updateKnowledge calls since the previous move,	  |
+// | searchTime includes the probability updates made during the search.		  |
+// | cacheHits counts components answered by the tablebase and guesses taken	  |
+// | from background speculation instead of a search; patternHits counts the	  |
+// | windows of patternDeduction found in the pattern table.					  |
+// O------------------------------------------------------------------------------O
+struct AI_Stats
+{
+	double knowledgeTime = 0.0;
+	double deductionTime = 0.0;
+	double labelTime = 0.0;
+	double searchTime = 0.0;
+	double probabilityTime = 0.0;
+	double totalTime = 0.0;
+	long long searchNodes = 0;
+	long long prunedBranches = 0;
+	long long leaves = 0;
+	long long constraintChecks = 0;
+	long long cacheHits = 0;
+	long long patternHits = 0;
+	int components = 0;
+	int largestComponent = 0;
+	int constrainedCells = 0;
+};
+
+// O------------------------------------------------------------------------------O
+// | Aggregates AI_Stats over many moves (and games). totals holds the sums of	  |
+// | all counters (the maximum for largestComponent). Move latencies are kept in  |
+// | a histogram with power-of-two buckets in microseconds.						  |
+// O------------------------------------------------------------------------------O
+class AI_StatsAggregate
+{
+public:
+	static const int BUCKETS = 40;
+	long long moves = 0;
+	long long histogram[BUCKETS] = {};
+	AI_Stats totals;
+	double maxTime = 0.0;
+	void add(const AI_Stats& stats);
+	//Upper bound of the bucket containing the given quantile (0..1) of move latencies, in microseconds
+	double percentile(double quantile) const;
+	void reset() { *this = AI_StatsAggregate(); }
+};
+
+//Adds the time between construction and destruction to total, in microseconds
+struct PhaseTimer
+{
+	double& total;
+	std::chrono::steady_clock::time_point begin;
+	PhaseTimer(double& total) : total(total), begin(std::chrono::steady_clock::now()) {}
+	~PhaseTimer() { total += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count(); }
+};
+
 // O------------------------------------------------------------------------------O
 // | Stores data on each connected component		                              |
 // O------------------------------------------------------------------------------O
@@ -88,9 +238,41 @@ struct ConnectedComponent
 	std::vector<VisibleCell*> cellsToSet;
 	std::vector<VisibleCell*> boundary;
 	long long validSamples = 0;
+	//Valid configurations found by the search, without the weights of validSamples
+	long long validLeaves = 0;
 	int label = -1;
 };
 
+// O------------------------------------------------------------------------------O
+// | All assignments of the cells of a connected component that satisfy its		  |
+// | boundary, counted by their number of mines: weights[k] (up to a common		  |
+// | scale) is the number of assignments with k mines, cellWeights[i][k] the	  |
+// | number of those in which cells[i] is a mine.								  |
+// O------------------------------------------------------------------------------O
+struct ComponentSolution
+{
+	std::vector<VisibleCell*> cells;
+	std::vector<double> weights;
+	std::vector<std::vector<double>> cellWeights;
+};
+
+// O------------------------------------------------------------------------------O
+// | The constraints of a connected component in local indices: constraint c	  |
+// | requires need[c] mines among the cells cellsOf[c] (indices into the		  |
+// | component's cellsToSet); constraintsOf[i] lists the constraints of cell i.	  |
+// | Cells with the same constraints are interchangeable and form a group:		  |
+// | groups[g] lists the cells of group g, groupsOf[c] the groups of constraint c.|
+// | The groups are ordered so that few constraints span a position.			  |
+// O------------------------------------------------------------------------------O
+struct ComponentConstraints
+{
+	std::vector<int> need;
+	std::vector<std::vector<int>> cellsOf;
+	std::vector<std::vector<int>> constraintsOf;
+	std::vector<std::vector<int>> groups;
+	std::vector<std::vector<int>> groupsOf;
+};
+
 // O------------------------------------------------------------------------------O
 // | The engine class. The updateKnowledge-method is called by the game-class	  |
 // | after each executed move to ensure that the engine's board state			  |
@@ -102,18 +284,45 @@ struct ConnectedComponent
 class CppSweeper_AI
 {
 private:
+	std::mutex defaultMutex;
 	std::vector<ConnectedComponent> components;
 	std::vector<KnowledgeDatum> knowledge;
 	//Used to distribute maxSamples over s subsearches, i.e. maxSamples_=maxSamples/s (used by stochasticMove_BoundaryBacktracking)
 	long long maxSamples_ = 0;
 	long long samplesCurrentCycle_ = 0;
+	//Search nodes of the current subsearch, bounded by searchNodesPerSample * maxSamples_
+	long long nodesCurrentCycle_ = 0;
 	long long totalSamples_ = 0;
 	long long validSamples_ = 0;
 	int unconstrainedCells = 0;
 	int _minProbX = -1;
 	int _minProbY = -1;
 	int knownMines = 0;
+	AI_Stats stats_;
+	double pendingKnowledgeTime_ = 0.0;
+	//Cells revealed since the last call of patternDeduction
+	std::vector<VisibleCell*> revealedCells;
+	/*State of the propagation engine (cf. unitPropagation)*/
+	std::vector<VisibleCell*> frontier;
+	std::vector<int> frontierIndex;
+	std::vector<PropagationConstraint> constraints;
+	std::vector<std::vector<int>> watches;
+	std::vector<signed char> assignment;
+	std::vector<int> trail;
+	std::vector<int> agenda;
+	std::vector<bool> onAgenda;
+	/*State of the gaussian elimination stage (cf. gaussianDeduction)*/
+	GaussianReduction reduction;
+	std::vector<int> rowPositions;
+	/*Messages of the last belief propagation by edge (cf. stochasticMove_belief), kept to warm-start the next move*/
+	std::unordered_map<long long, std::vector<double>> beliefMessages;
+	/*Union-find over the board positions and the labels of its roots (cf. labelConnectedComponents on tiled boards)*/
+	std::vector<int> tileParent;
+	std::vector<int> tileLabel;
 	int labelConnectedComponents(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet, std::vector<VisibleCell*>* boundary);
+	int labelTiledComponents(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet, int tiles);
+	int tiles(CppSweeper* game);
+	void runTiles(int tiles, const std::function<void(int)>& pass);
 	void setProbabilitiesFromSamples(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet);
 	int nChoosek(int n, int k);
 	void boundaryBacktracking(CppSweeper* game, std::vector<VisibleCell*>* boundary, std::vector<VisibleCell*>* cellsToSet, std::vector<VisibleCell*>::iterator cellToSet, int remainingMines);
@@ -126,20 +335,95 @@ private:
 	std::tuple<int, int> stochasticMove_singleConstraint(CppSweeper* game);
 	std::tuple<int, int> stochasticMove_random(CppSweeper* game);
 	std::tuple<int, int> getMinimumProbabilityCell(CppSweeper* game);
+	std::tuple<int, int> stochasticMove(CppSweeper* game);
+	double edgeBias(CppSweeper* game, int x, int y);
+	void collectBoundary(CppSweeper* game, std::vector<VisibleCell*>* boundary, std::vector<VisibleCell*>* cellsToSet);
+	bool knownSafeMove(CppSweeper* game, std::tuple<int, int>& safeMove);
+	void applyDeductions(const std::vector<VisibleCell*>& safeCells, const std::vector<VisibleCell*>& mineCells);
+	void buildPropagationConstraints(CppSweeper* game);
+	bool assign(int cell, signed char value);
+	bool propagate();
+	void undoTrail(size_t trailSize);
+	int patternDeduction(CppSweeper* game);
+	int unitPropagation(CppSweeper* game);
+	int gaussianDeduction(CppSweeper* game);
+	void prepareForcedCells(std::vector<VisibleCell*>* cellsToSet);
+	int forcedValue(VisibleCell* cell);
+	void buildComponentConstraints(const ConnectedComponent& component, ComponentConstraints* constraints);
+	bool enumerateComponent(const ConnectedComponent& component, long long maxNodes, ComponentSolution* solution);
+	bool frontierDP(const ConnectedComponent& component, ComponentSolution* solution);
+	bool bitslicedEnumerate(const ConnectedComponent& component, long long maxNodes, ComponentSolution* solution);
+	bool grayCodeEnumerate(const ConnectedComponent& component, ComponentSolution* solution);
+	bool solveComponent(const ConnectedComponent& component, long long maxNodes, ComponentSolution* solution);
+	void combineSolutions(CppSweeper* game, std::vector<ComponentSolution>* solutions, int outsideMines);
+	void biasUnconstrainedCells(CppSweeper* game);
+	bool exactProbabilities(CppSweeper* game, long long maxNodes);
+	std::tuple<int, int> stochasticMove_exact(CppSweeper* game);
+	void sampleComponent(CppSweeper* game, ConnectedComponent* component, double target);
+	bool samplingSettled(const ConnectedComponent* component, double target);
+	std::tuple<int, int> stochasticMove_cascade(CppSweeper* game);
+	std::tuple<int, int> stochasticMove_belief(CppSweeper* game);
 public:
+	//Guards knowledge against concurrent reads by the frontend. Points to an engine-owned mutex unless replaced.
 	std::mutex* m;
 	bool rotate = true;
-	bool interrupt = false;
+	//Set from another thread to end a running move early with what it has found so far. move leaves it set; whoever starts the
+	//next move clears it first, so that an interrupt arriving before the move begins is not lost.
+	std::atomic<bool> interrupt{ false };
 	long long maxSamples = 1000000;
-	long long moves;
-	long long guesses;
+	//Bounds the nodes of a backtracking search to this many per sample of its budget, so that a search whose branches are
+	//mostly pruned (cf. forcedValue) still ends; maxSamples itself only counts completed samples
+	long long searchNodesPerSample = 4;
+	//Upper bound on the failed-literal probes per call of unitPropagation
+	int maxProbes = 256;
+	//Gaussian elimination is skipped for frontiers with more cells than this
+	int gaussianMaxCells = 2048;
+	//Bounds of the exact solvers: states per layer of frontierDP, and search nodes per component of the enumeration
+	//that replaces it when the frontier is too wide. METHOD_EXACT falls back to backtracking beyond them.
+	int frontierMaxStates = 1 << 18;
+	long long exactMaxNodes = 20000000;
+	//Components with at most this many cells are enumerated by grayCodeEnumerate, resp. bitslicedEnumerate, before the
+	//frontier DP is tried
+	int grayCodeMaxCells = 7;
+	int bitslicedMaxCells = 32;
+	//METHOD_BACKTRACKING solves the components exactly instead of sampling them if none has more cells than this
+	int exactFastPathCells = 32;
+	//METHOD_CASCADE: search nodes allowed for the exact solution of components larger than exactFastPathCells before they are
+	//sampled, and the width (in standard errors) of the intervals that decide when the sampling of a component may stop
+	long long cascadeMaxNodes = 200000;
+	double cascadeConfidence = 3.0;
+	//METHOD_BELIEF: iterations of belief propagation per move, the weight of the previous message in each update, and the
+	//largest change of a message at which the propagation counts as converged
+	int beliefMaxIterations = 200;
+	double beliefDamping = 0.5;
+	double beliefTolerance = 1e-4;
+	//Boards of at least tileMinCells cells are split into tiles of whole columns for the passes over the board (collectBoundary,
+	//labelConnectedComponents, patternDeduction and the constraints of unitPropagation and gaussianDeduction), which then run on
+	//tileThreads threads; with one thread (or on smaller boards) the passes run unsplit on the calling thread
+	int tileThreads = 1;
+	long long tileMinCells = 1 << 18;
+	//Workers of the tiled passes; created with tileThreads threads on first use if not set. May be shared by several engines,
+	//whose tiled passes then run one at a time
+	std::shared_ptr<TilePool> tilePool;
+	//Solved components looked up before any solver runs (cf. TablebaseSweeper); not owned, may be shared by several engines
+	const SweeperTablebase* tablebase = nullptr;
+	//Positions solved ahead of time in the background (cf. SweeperSpeculation); a guess takes the probability map from there if
+	//the position has been solved with the same settings. Not owned.
+	SweeperSpeculation* speculation = nullptr;
+	//Receives the probability map, component labels and counters after every move, for viewers in other processes
+	//(cf. SweeperMapReader). Not owned.
+	SweeperMapPublisher* publisher = nullptr;
+	long long moves = 0;
+	long long guesses = 0;
 	AI_Move lastMove;
 	int connectedComponents() { return components.size(); }
 	int minProbX() { return _minProbX; }
 	int minProbY() { return _minProbY; }
 	long long samples() { return totalSamples_ + samplesCurrentCycle_; }
 	long long validSamples() { return validSamples_; }
+	const AI_Stats& lastStats() { return stats_; }
 	const std::vector<KnowledgeDatum>& getKnowledge() { return knowledge; }
+	const GaussianReduction& getReduction() { return reduction; }
 	void sortKnowledge();
 	void updateKnowledge(CppSweeper* game, int x, int y);
 	StochasticMethod stochasticMethod = StochasticMethod::METHOD_BACKTRACKING;
@@ -147,6 +431,36 @@ public:
 	void toggleFlags(CppSweeper* game);
 	void reset();
 	CppSweeper_AI();
+
+	// O------------------------------------------------------------------------------O
+	// | The stages of move on their own, for the tools that run or time them		  |
+	// | separately (cf. BenchSweeper, AnalyzeSweeper, TablebaseSweeper). Each		  |
+	// | leaves the engine in the state the stage leaves it in during a move.		  |
+	// O------------------------------------------------------------------------------O
+	class Stages
+	{
+	private:
+		CppSweeper_AI& engine_;
+	public:
+		explicit Stages(CppSweeper_AI& engine) : engine_(engine) {}
+		int gaussianDeduction(CppSweeper* game) { return engine_.gaussianDeduction(game); }
+		void collectBoundary(CppSweeper* game, std::vector<VisibleCell*>* boundary, std::vector<VisibleCell*>* cellsToSet) { engine_.collectBoundary(game, boundary, cellsToSet); }
+		int labelConnectedComponents(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet, std::vector<VisibleCell*>* boundary) { return engine_.labelConnectedComponents(game, cellsToSet, boundary); }
+		//The components found by labelConnectedComponents
+		std::vector<ConnectedComponent>& components() { return engine_.components; }
+		//Prepares a backtracking search of component with a budget of maxSamples, as for one pass of METHOD_BACKTRACKING
+		void prepareSearch(CppSweeper* game, ConnectedComponent& component, long long maxSamples);
+		//Runs the prepared search and returns the samples it took; the simMine flags of the cells of component are left set
+		long long search(CppSweeper* game, ConnectedComponent& component);
+		void setProbabilitiesFromSamples(CppSweeper* game, std::vector<VisibleCell*>* cellsToSet) { engine_.setProbabilitiesFromSamples(game, cellsToSet); }
+		bool solveComponent(const ConnectedComponent& component, long long maxNodes, ComponentSolution* solution) { return engine_.solveComponent(component, maxNodes, solution); }
+		bool exactProbabilities(CppSweeper* game, long long maxNodes) { return engine_.exactProbabilities(game, maxNodes); }
+		//Sets the probabilities of all covered cells with the stochasticMethod, also where a cell is known to be safe, and returns the
+		//cell with the lowest
+		std::tuple<int, int> stochasticMove(CppSweeper* game) { return engine_.stochasticMove(game); }
+		std::tuple<int, int> minimumProbabilityCell(CppSweeper* game) { return engine_.getMinimumProbabilityCell(game); }
+	};
+	Stages stages() { return Stages(*this); }
 };
 
 // O------------------------------------------------------------------------------O
@@ -158,8 +472,9 @@ public:
 class CppSweeper
 {
 private:
-	Cell* field;
-	VisibleCell* visibleField;
+	Cell* field = nullptr;
+	VisibleCell* visibleField = nullptr;
+	BoardGeometry geometry_;
 	std::default_random_engine generator;
 	bool firstClick_ = true;
 	int flagCount_ = mineCount;
@@ -168,8 +483,13 @@ private:
 	bool gameLost_ = false;
 	int wins_ = 0;
 	int losses_ = 0;
+	//The moves of the current game; replayable_ is set if the field was generated right after seeding
+	SweeperReplay replay_;
+	bool seedFresh_ = false;
+	bool replayable_ = false;
+	bool uncovering_ = false;
 	void uncoverNeighbours(int x, int y);
-	void generateField(int safeX, int safeY);
+	void linkCells();
 	std::vector<Cell*> getNeighbourCells(int x, int y);
 public:
 	int width = 30;
@@ -177,11 +497,14 @@ public:
 	int mineCount = 99;
 	bool firstClick_zeroNeighbours = false;
 	std::tuple<int, int> lastClicked;
-	CppSweeper_AI* AI;
+	CppSweeper_AI* AI = nullptr;
 
 	std::vector<VisibleCell*> getVisibleNeighbourCells(int x, int y);
 	VisibleCell* getCell(int x, int y);
 	VisibleCell* getCell(std::tuple<int, int> coord);
+	//True if a covered cell is left that the engine does not know to be a mine. A position set up by loadPosition is not
+	//marked as won, so check this before asking the engine for a move on it.
+	bool moveLeft();
 	int flagCount() { return flagCount_; }
 	int uncoveredCells() { return uncoveredCells_; }
 	bool firstClick() { return firstClick_;  }
@@ -192,6 +515,13 @@ public:
 	bool click(int x, int y);
 	void toggleFlag(int x, int y);
 	void resetGame();
+	//Places the mines, leaving (safeX,safeY) free (and its neighbours if firstClick_zeroNeighbours); done by the first click
+	void generateField(int safeX, int safeY);
+	void seed(unsigned int seed);
+	SweeperPosition getPosition();
+	void loadPosition(const SweeperPosition& position);
+	bool getReplay(SweeperReplay* replay);
+	void playReplay(const SweeperReplay& replay);
 	void resetStats() { 
 		wins_ = 0;
 		losses_ = 0;
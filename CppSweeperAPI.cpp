@@ -0,0 +1,173 @@
+#include "CppSweeperAPI.h"
+#include "CppSweeper.h"
+#include "CppSweeperTablebase.h"
+#include "CppSweeperTiles.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+struct CppSweeperEvaluator
+{
+	//A game and an engine kept warm between boards; the position is reused to hold each board
+	struct Worker
+	{
+		CppSweeper game;
+		CppSweeper_AI engine;
+		SweeperPosition position;
+	};
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::unique_ptr<TilePool> pool;
+	SweeperTablebase tablebase;
+
+	static bool valid(const CppSweeperBoard& board);
+	bool evaluate(Worker* worker, const CppSweeperBoard& board, CppSweeperResult* result);
+};
+
+bool CppSweeperEvaluator::valid(const CppSweeperBoard& board)
+{
+	if ((board.cells == nullptr) || (board.width <= 0) || (board.height <= 0) || (board.width > 0x7FFF) || (board.height > 0x7FFF) ||
+		(board.mineCount < 0) || ((long long)board.mineCount > (long long)board.width * board.height))
+		return false;
+	for (long long i = 0; i < (long long)board.width * board.height; i++)
+		if ((board.cells[i] < CPPSWEEPER_FLAGGED) || (board.cells[i] > 8))
+			return false;
+	//A number cannot exceed its covered and flagged neighbours
+	for (int y = 0; y < board.height; y++)
+		for (int x = 0; x < board.width; x++)
+		{
+			int8_t value = board.cells[x + (long long)y * board.width];
+			if (value <= 0)
+				continue;
+			int unrevealed = 0;
+			for (int ny = std::max(0, y - 1); ny <= std::min(board.height - 1, y + 1); ny++)
+				for (int nx = std::max(0, x - 1); nx <= std::min(board.width - 1, x + 1); nx++)
+					if (board.cells[nx + (long long)ny * board.width] < 0)
+						unrevealed++;
+			if (value > unrevealed)
+				return false;
+		}
+	return true;
+}
+
+bool CppSweeperEvaluator::evaluate(Worker* worker, const CppSweeperBoard& board, CppSweeperResult* result)
+{
+	result->moveType = CPPSWEEPER_MOVE_NONE;
+	result->x = -1;
+	result->y = -1;
+	result->probability = 0.0;
+	if (!valid(board))
+	{
+		result->status = CPPSWEEPER_INVALID;
+		return false;
+	}
+	SweeperPosition& position = worker->position;
+	position.width = board.width;
+	position.height = board.height;
+	position.mineCount = board.mineCount;
+	position.cells.assign(board.cells, board.cells + board.width * board.height);
+	CppSweeper& game = worker->game;
+	CppSweeper_AI& engine = worker->engine;
+	game.loadPosition(position);
+
+	//A board without a cell left to click gets no move
+	std::tuple<int, int> move(-1, -1);
+	if (game.moveLeft())
+		move = engine.move(&game);
+	if (std::get<0>(move) >= 0)
+	{
+		result->x = std::get<0>(move);
+		result->y = std::get<1>(move);
+		if (engine.lastMove.moveType == MoveType::MOVE_DETERMINISTIC)
+			result->moveType = CPPSWEEPER_MOVE_SAFE;
+		else
+		{
+			result->moveType = CPPSWEEPER_MOVE_GUESS;
+			result->probability = engine.lastMove.probability;
+		}
+	}
+	if (result->probabilities != nullptr)
+	{
+		//A deduced move leaves the probabilities unset; run the stochastic method for them
+		if (result->moveType == CPPSWEEPER_MOVE_SAFE)
+			engine.stages().stochasticMove(&game);
+		for (int y = 0; y < game.height; y++)
+			for (int x = 0; x < game.width; x++)
+			{
+				VisibleCell* cell = game.getCell(x, y);
+				result->probabilities[x + y * game.width] = cell->clicked ? -1.0f : (float)cell->mineProbability;
+			}
+	}
+	result->status = CPPSWEEPER_OK;
+	return true;
+}
+
+int cppsweeper_api_version(void)
+{
+	return CPPSWEEPER_API_VERSION;
+}
+
+void cppsweeper_default_options(CppSweeperOptions* options)
+{
+	CppSweeper_AI engine;
+	options->threads = 0;
+	options->method = (int32_t)engine.stochasticMethod;
+	options->maxSamples = engine.maxSamples;
+	options->tablebase = nullptr;
+}
+
+CppSweeperEvaluator* cppsweeper_create(const CppSweeperOptions* options)
+{
+	if ((options == nullptr) || (options->threads < 0) || (options->method < 0) || (options->method > (int32_t)StochasticMethod::METHOD_BELIEF) ||
+		(options->maxSamples < 0))
+		return nullptr;
+	std::unique_ptr<CppSweeperEvaluator> evaluator(new (std::nothrow) CppSweeperEvaluator());
+	if (evaluator == nullptr)
+		return nullptr;
+	if ((options->tablebase != nullptr) && !evaluator->tablebase.open(options->tablebase))
+		return nullptr;
+	int threads = (options->threads > 0) ? options->threads : std::max(1, (int)std::thread::hardware_concurrency());
+	for (int i = 0; i < threads; i++)
+	{
+		CppSweeperEvaluator::Worker* worker = new (std::nothrow) CppSweeperEvaluator::Worker();
+		if (worker == nullptr)
+			return nullptr;
+		evaluator->workers.emplace_back(worker);
+		worker->game.AI = &worker->engine;
+		worker->engine.tileThreads = 1;
+		worker->engine.stochasticMethod = (StochasticMethod)options->method;
+		if (options->maxSamples > 0)
+			worker->engine.maxSamples = options->maxSamples;
+		if (options->tablebase != nullptr)
+			worker->engine.tablebase = &evaluator->tablebase;
+	}
+	evaluator->pool.reset(new (std::nothrow) TilePool(threads));
+	if (evaluator->pool == nullptr)
+		return nullptr;
+	return evaluator.release();
+}
+
+void cppsweeper_destroy(CppSweeperEvaluator* evaluator)
+{
+	delete evaluator;
+}
+
+size_t cppsweeper_evaluate(CppSweeperEvaluator* evaluator, const CppSweeperBoard* boards, CppSweeperResult* results, size_t count)
+{
+	if ((evaluator == nullptr) || (count == 0) || (boards == nullptr) || (results == nullptr))
+		return 0;
+	//One task per worker; the tasks take boards from a shared counter, so a slow board does not hold up the others
+	std::atomic<size_t> next{ 0 };
+	std::atomic<size_t> evaluated{ 0 };
+	int tasks = (int)std::min(evaluator->workers.size(), count);
+	evaluator->pool->run(tasks, [&](int task) {
+		CppSweeperEvaluator::Worker* worker = evaluator->workers[task].get();
+		size_t done = 0;
+		for (size_t i = next++; i < count; i = next++)
+			done += evaluator->evaluate(worker, boards[i], &results[i]) ? 1 : 0;
+		evaluated += done;
+	});
+	return evaluated;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// O------------------------------------------------------------------------------O
+// | C interface for evaluating many positions in one call, for programs that	  |
+// | embed the engine without playing games through CppSweeper. An evaluator	  |
+// | keeps a game and an engine per worker thread (and the tablebase) between	  |
+// | calls; cppsweeper_evaluate loads each board into one of them, takes the	  |
+// | engine's move and writes it, and the mine probability of every cell if		  |
+// | asked for, into the results. Nothing is allocated per board beyond what	  |
+// | the engine needs to solve it, and no pointer into the library is kept by	  |
+// | the caller. The layout of the structs only grows at the end; check		  |
+// | cppsweeper_api_version against CPPSWEEPER_API_VERSION.					  |
+// O------------------------------------------------------------------------------O
+#define CPPSWEEPER_API_VERSION 1
+
+//Define as __declspec(dllexport)/(dllimport) or a visibility attribute when building or using a shared library
+#ifndef CPPSWEEPER_API
+#define CPPSWEEPER_API
+#endif
+
+//Cell values of a board besides the revealed numbers 0..8, as in SweeperPosition
+enum { CPPSWEEPER_COVERED = -1, CPPSWEEPER_FLAGGED = -2 };
+//Move types of a result
+enum { CPPSWEEPER_MOVE_NONE = 0, CPPSWEEPER_MOVE_SAFE = 1, CPPSWEEPER_MOVE_GUESS = 2 };
+//Status of a result
+enum { CPPSWEEPER_OK = 0, CPPSWEEPER_INVALID = 1 };
+
+typedef struct CppSweeperOptions
+{
+	//Worker threads, 0: one per hardware thread. Each worker evaluates whole boards on its own thread; the passes of its engine
+	//are not split further into tiles (CppSweeper_AI::tileThreads stays 1), so threads is the total used by an evaluator
+	int32_t threads;
+	//A StochasticMethod value
+	int32_t method;
+	//Sample budget of the sampling methods, 0: the engine default
+	int64_t maxSamples;
+	//Path of a tablebase file (cf. TablebaseSweeper), or NULL
+	const char* tablebase;
+} CppSweeperOptions;
+
+typedef struct CppSweeperBoard
+{
+	int32_t width;
+	int32_t height;
+	int32_t mineCount;
+	//width*height values indexed by x+y*width: the revealed number, CPPSWEEPER_COVERED or CPPSWEEPER_FLAGGED. A board with a
+	//number above its count of covered and flagged neighbours is invalid.
+	const int8_t* cells;
+} CppSweeperBoard;
+
+typedef struct CppSweeperResult
+{
+	//Set by the caller: a buffer of width*height floats for the mine probabilities (-1 for revealed cells), or NULL
+	float* probabilities;
+	//Set by the library; moveType is CPPSWEEPER_MOVE_NONE if no covered cell is left that is not known to be a mine
+	int32_t status;
+	int32_t moveType;
+	int32_t x;
+	int32_t y;
+	//Mine probability of the move, 0 for a safe move
+	double probability;
+} CppSweeperResult;
+
+typedef struct CppSweeperEvaluator CppSweeperEvaluator;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+CPPSWEEPER_API int cppsweeper_api_version(void);
+CPPSWEEPER_API void cppsweeper_default_options(CppSweeperOptions* options);
+//Returns NULL if options is invalid, the tablebase cannot be read or memory runs out
+CPPSWEEPER_API CppSweeperEvaluator* cppsweeper_create(const CppSweeperOptions* options);
+CPPSWEEPER_API void cppsweeper_destroy(CppSweeperEvaluator* evaluator);
+//Evaluates boards[0..count-1] into results[0..count-1] on the worker threads and returns the number of boards with status
+//CPPSWEEPER_OK. An evaluator runs one call at a time; use several evaluators to evaluate from several threads.
+CPPSWEEPER_API size_t cppsweeper_evaluate(CppSweeperEvaluator* evaluator, const CppSweeperBoard* boards, CppSweeperResult* results, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
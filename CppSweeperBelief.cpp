@@ -0,0 +1,359 @@
+#include "CppSweeper.h"
+#include "CppSweeperTrace.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <map>
+
+static double logOdds(double p)
+{
+	p = std::min(1.0 - 1e-12, std::max(1e-12, p));
+	return std::log(p / (1.0 - p));
+}
+
+static double probabilityOf(double logOdds)
+{
+	return 1.0 / (1.0 + std::exp(-std::min(30.0, std::max(-30.0, logOdds))));
+}
+
+//Scales values[0..count-1] to a sum of 1, or makes them uniform if they are all zero
+static void normalize(double* values, int count)
+{
+	double sum = 0.0;
+	for (int i = 0; i < count; i++)
+		sum += values[i];
+	for (int i = 0; i < count; i++)
+		values[i] = (sum > 0.0) ? values[i] / sum : 1.0 / count;
+}
+
+//The distribution of the mine count of size cells that are mines independently with probability density; a group has at most
+//the 8 cells around one boundary cell
+static void binomialPrior(int size, double density, double* prior)
+{
+	assert((size >= 0) && (size <= 8));
+	for (int c = 0; c <= size; c++)
+		prior[c] = binomialTable.values[size][c] * std::pow(density, c) * std::pow(1.0 - density, size - c);
+}
+
+//The factor graph of a position. Its variables are the groups of constrained cells with the same boundary cells around them
+//(cf. ComponentConstraints), valued by their number of mines; grouping removes the short loops between cells that share all
+//their constraints, which would otherwise count the same evidence several times. Factor f requires need[f] mines among the
+//groups of its edges firstEdge[f]..firstEdge[f+1]-1. The messages of edge e are distributions over the mine count of its
+//group, stored from offset[e] in toGroup and toFactor; key[e] identifies the edge across moves.
+struct BeliefGraph
+{
+	std::vector<int> need;
+	std::vector<int> firstEdge;
+	std::vector<int> group;
+	std::vector<long long> key;
+	std::vector<int> offset;
+	std::vector<double> toGroup;
+	std::vector<double> toFactor;
+	std::vector<std::vector<int>> cells;
+	std::vector<std::vector<int>> edgesOf;
+
+	int sizeOf(int e) const { return (int)cells[group[e]].size(); }
+
+	//Sets the messages from factor f to its groups from the messages of the groups; returns the largest change of a message
+	double updateFactor(int f, double damping)
+	{
+		double change = 0.0;
+		double distribution[9], next[9], message[9];
+		for (int j = firstEdge[f]; j < firstEdge[f + 1]; j++)
+		{
+			//distribution[k]: the probability that the other groups of the factor hold k mines
+			distribution[0] = 1.0;
+			int length = 1;
+			for (int i = firstEdge[f]; i < firstEdge[f + 1]; i++)
+				if (i != j)
+				{
+					const double* q = &toFactor[offset[i]];
+					int size = sizeOf(i);
+					std::fill(next, next + length + size, 0.0);
+					for (int k = 0; k < length; k++)
+						for (int v = 0; v <= size; v++)
+							next[k + v] += distribution[k] * q[v];
+					length += size;
+					std::copy(next, next + length, distribution);
+				}
+			int size = sizeOf(j);
+			for (int v = 0; v <= size; v++)
+			{
+				int rest = need[f] - v;
+				message[v] = ((rest >= 0) && (rest < length)) ? distribution[rest] : 0.0;
+			}
+			normalize(message, size + 1);
+			double* old = &toGroup[offset[j]];
+			for (int v = 0; v <= size; v++)
+			{
+				double updated = damping * old[v] + (1.0 - damping) * message[v];
+				change = std::max(change, std::fabs(updated - old[v]));
+				old[v] = updated;
+			}
+		}
+		return change;
+	}
+
+	//Sets the messages from group g to its factors, given the density of the mines, and its mine count distribution in belief;
+	//raises *change to the largest change of a message
+	void updateGroup(int g, double density, double damping, double* belief, double* change)
+	{
+		int size = (int)cells[g].size();
+		double prior[9], message[9];
+		binomialPrior(size, density, prior);
+		for (int e : edgesOf[g])
+		{
+			std::copy(prior, prior + size + 1, message);
+			for (int other : edgesOf[g])
+				if (other != e)
+					for (int c = 0; c <= size; c++)
+						message[c] *= toGroup[offset[other] + c];
+			normalize(message, size + 1);
+			double* old = &toFactor[offset[e]];
+			for (int c = 0; c <= size; c++)
+			{
+				double updated = damping * old[c] + (1.0 - damping) * message[c];
+				*change = std::max(*change, std::fabs(updated - old[c]));
+				old[c] = updated;
+			}
+		}
+		std::copy(prior, prior + size + 1, belief);
+		for (int e : edgesOf[g])
+			for (int c = 0; c <= size; c++)
+				belief[c] *= toGroup[offset[e] + c];
+		normalize(belief, size + 1);
+	}
+};
+
+//Estimates the mine probabilities by loopy belief propagation on the constraints of the boundary, for frontiers too large for
+//the exact solvers and for sampling. Each iteration updates all messages of the factors (boundary cells) from those of the
+//groups of cells and then all messages of the groups (a flooding schedule, so the factors are independent of each other), and
+//costs time linear in the size of the boundary. The count of all mines enters as a prior on every constrained cell: the density
+//of the mines that the groups leave to the unconstrained cells, or, without unconstrained cells, the density that makes the
+//groups hold the remaining mines. The messages are damped, kept to start the next move from, and the propagation stops after
+//beliefMaxIterations, so the probabilities are approximate but bounded in time for components of any size.
+std::tuple<int, int> CppSweeper_AI::stochasticMove_belief(CppSweeper* game)
+{
+	TRACE_SCOPE("belief propagation");
+	std::vector<VisibleCell*> boundary;
+	std::vector<VisibleCell*> cellsToSet;
+	{
+		PhaseTimer timer(stats_.labelTime);
+		collectBoundary(game, &boundary, &cellsToSet);
+	}
+	stats_.constrainedCells = (int)cellsToSet.size();
+	_minProbX = -1;
+	_minProbY = -1;
+
+	int remainingMines = game->mineCount - knownMines;
+	int coveredCells = game->width * game->height - knownMines - game->uncoveredCells();
+	int frontierCells = (int)cellsToSet.size();
+	int unconstrained = coveredCells - frontierCells;
+	double density = (coveredCells > 0) ? (double)remainingMines / coveredCells : 0.0;
+
+	//The constraints of the boundary cells, each as the sorted variables (constrained cells) around it and the mines they hold
+	std::vector<int> variableAt((size_t)game->width * game->height, -1);
+	for (unsigned v = 0; v < cellsToSet.size(); v++)
+		variableAt[cellsToSet[v]->x + cellsToSet[v]->y * game->width] = (int)v;
+	std::vector<int> needs;
+	std::vector<std::vector<int>> variablesOf;
+	std::vector<VisibleCell*> factorCells;
+	std::vector<std::vector<int>> containing(cellsToSet.size());
+	for (auto itr = boundary.begin(); itr != boundary.end(); itr++)
+	{
+		int need = (*itr)->neighbouringMines;
+		std::vector<int> variables;
+		for (auto neighbour = (*itr)->neighbouringCells.begin(); neighbour != (*itr)->neighbouringCells.end(); neighbour++)
+		{
+			if ((*neighbour)->knownMine)
+				need--;
+			int v = variableAt[(*neighbour)->x + (*neighbour)->y * game->width];
+			if (v != -1)
+				variables.push_back(v);
+		}
+		std::sort(variables.begin(), variables.end());
+		for (int v : variables)
+			containing[v].push_back((int)needs.size());
+		needs.push_back(need);
+		variablesOf.push_back(variables);
+		factorCells.push_back(*itr);
+	}
+
+	//A constraint containing all cells of another one requires the difference of their mines on its other cells (as in
+	//updateKnowledge). Reducing the constraints this way leaves their solutions unchanged, but turns the redundant ones into
+	//duplicates that are dropped, so that the propagation does not count the same evidence twice. A constraint only loses
+	//cells, so containing[v] still lists every constraint on v.
+	bool reduced = true;
+	for (int pass = 0; reduced && (pass < 4); pass++)
+	{
+		reduced = false;
+		for (unsigned f = 0; f < variablesOf.size(); f++)
+			for (unsigned i = 0; i < variablesOf[f].size(); i++)
+				for (int g : containing[variablesOf[f][i]])
+				{
+					const std::vector<int>& inner = variablesOf[g];
+					if (((unsigned)g == f) || (inner.size() == 0) || (inner[0] != variablesOf[f][i]) || (inner.size() >= variablesOf[f].size())
+						|| !std::includes(variablesOf[f].begin(), variablesOf[f].end(), inner.begin(), inner.end()))
+						continue;
+					std::vector<int> rest;
+					std::set_difference(variablesOf[f].begin(), variablesOf[f].end(), inner.begin(), inner.end(), std::back_inserter(rest));
+					variablesOf[f].swap(rest);
+					needs[f] -= needs[g];
+					reduced = true;
+					i = (unsigned)-1;
+					break;
+				}
+	}
+
+	//The factors: the distinct nonempty constraints, and the factors of each constrained cell
+	BeliefGraph graph;
+	std::vector<std::vector<int>> factorsOf(cellsToSet.size());
+	std::map<std::vector<int>, int> distinct;
+	int kept = 0;
+	for (unsigned f = 0; f < variablesOf.size(); f++)
+	{
+		//An inconsistent constraint (cf. flags the player set on safe cells) is left out
+		if ((variablesOf[f].size() == 0) || (needs[f] < 0) || (needs[f] > (int)variablesOf[f].size()) || !distinct.insert(std::make_pair(variablesOf[f], f)).second)
+			continue;
+		for (int v : variablesOf[f])
+			factorsOf[v].push_back((int)graph.need.size());
+		graph.need.push_back(needs[f]);
+		variablesOf[kept] = variablesOf[f];
+		factorCells[kept] = factorCells[f];
+		kept++;
+	}
+	variablesOf.resize(kept);
+	factorCells.resize(kept);
+	//The cells sharing a factor are neighbours of its boundary cell, so a group has at most 8 cells. A cell left without a factor
+	//(its constraints all dropped) is a group of its own.
+	std::map<std::vector<int>, int> groupOf;
+	std::vector<int> groupOfVariable(cellsToSet.size());
+	for (unsigned v = 0; v < cellsToSet.size(); v++)
+	{
+		if (factorsOf[v].size() == 0)
+		{
+			groupOfVariable[v] = (int)graph.cells.size();
+			graph.cells.push_back(std::vector<int>(1, (int)v));
+			continue;
+		}
+		auto found = groupOf.find(factorsOf[v]);
+		if (found == groupOf.end())
+		{
+			found = groupOf.insert(std::make_pair(factorsOf[v], (int)graph.cells.size())).first;
+			graph.cells.push_back(std::vector<int>());
+		}
+		groupOfVariable[v] = found->second;
+		graph.cells[found->second].push_back((int)v);
+	}
+	graph.edgesOf.resize(graph.cells.size());
+
+	//One edge per factor and group, starting from the messages of the last move if the edge existed then. An edge is
+	//identified by its boundary cell and the direction of the first cell of the group.
+	int factors = (int)graph.need.size();
+	for (int f = 0; f < factors; f++)
+	{
+		graph.firstEdge.push_back((int)graph.group.size());
+		for (int v : variablesOf[f])
+		{
+			int g = groupOfVariable[v];
+			if ((graph.edgesOf[g].size() > 0) && (graph.edgesOf[g].back() >= graph.firstEdge[f]))
+				continue;
+			int size = (int)graph.cells[g].size();
+			long long key = ((long long)factorCells[f]->x + (long long)factorCells[f]->y * game->width) * 9
+				+ (cellsToSet[v]->x - factorCells[f]->x + 1) + (cellsToSet[v]->y - factorCells[f]->y + 1) * 3;
+			graph.edgesOf[g].push_back((int)graph.group.size());
+			graph.group.push_back(g);
+			graph.key.push_back(key);
+			graph.offset.push_back((int)graph.toGroup.size());
+			auto previous = beliefMessages.find(key);
+			if ((previous != beliefMessages.end()) && ((int)previous->second.size() == 2 * (size + 1)))
+			{
+				graph.toGroup.insert(graph.toGroup.end(), previous->second.begin(), previous->second.begin() + size + 1);
+				graph.toFactor.insert(graph.toFactor.end(), previous->second.begin() + size + 1, previous->second.end());
+			}
+			else
+			{
+				double prior[9];
+				binomialPrior(size, density, prior);
+				graph.toGroup.insert(graph.toGroup.end(), size + 1, 1.0 / (size + 1));
+				graph.toFactor.insert(graph.toFactor.end(), prior, prior + size + 1);
+			}
+		}
+	}
+	graph.firstEdge.push_back((int)graph.group.size());
+
+	std::vector<double> beliefs(graph.cells.size() * 9, 0.0);
+	{
+		PhaseTimer timer(stats_.searchTime);
+		for (int iteration = 0; (iteration < beliefMaxIterations) && (frontierCells > 0); iteration++)
+		{
+			double change = 0.0;
+			for (int f = 0; f < factors; f++)
+				change = std::max(change, graph.updateFactor(f, beliefDamping));
+			stats_.searchNodes += factors;
+
+			double expectedMines = 0.0;
+			for (unsigned g = 0; g < graph.cells.size(); g++)
+			{
+				graph.updateGroup(g, density, beliefDamping, &beliefs[g * 9], &change);
+				for (unsigned c = 1; c <= graph.cells[g].size(); c++)
+					expectedMines += c * beliefs[g * 9 + c];
+			}
+
+			//The density follows the mines the groups leave to the rest of the board
+			double target;
+			if (unconstrained > 0)
+				target = logOdds((remainingMines - expectedMines) / unconstrained);
+			else
+				target = logOdds(density) + logOdds((double)remainingMines / frontierCells) - logOdds(expectedMines / frontierCells);
+			double updated = probabilityOf(beliefDamping * logOdds(density) + (1.0 - beliefDamping) * target);
+			change = std::max(change, std::fabs(updated - density));
+			density = updated;
+			if (change < beliefTolerance)
+				break;
+		}
+	}
+
+	std::tuple<int, int> move;
+	{
+		PhaseTimer timer(stats_.probabilityTime);
+		std::unordered_map<long long, std::vector<double>> messages;
+		messages.reserve(graph.group.size());
+		for (size_t e = 0; e < graph.group.size(); e++)
+		{
+			int size = graph.sizeOf((int)e);
+			std::vector<double>& stored = messages[graph.key[e]];
+			stored.assign(graph.toGroup.begin() + graph.offset[e], graph.toGroup.begin() + graph.offset[e] + size + 1);
+			stored.insert(stored.end(), graph.toFactor.begin() + graph.offset[e], graph.toFactor.begin() + graph.offset[e] + size + 1);
+		}
+		beliefMessages.swap(messages);
+
+		double frontierMines = 0.0;
+		for (unsigned g = 0; g < graph.cells.size(); g++)
+		{
+			int size = (int)graph.cells[g].size();
+			double mines = 0.0;
+			for (int c = 1; c <= size; c++)
+				mines += c * beliefs[g * 9 + c];
+			frontierMines += mines;
+			for (int v : graph.cells[g])
+				cellsToSet[v]->mineProbability = mines / size;
+		}
+		double blankProbability = (unconstrained > 0) ? std::min(1.0, std::max(0.0, (remainingMines - frontierMines) / unconstrained)) : 0.0;
+		for (int x = 0; x < game->width; x++)
+			for (int y = 0; y < game->height; y++)
+			{
+				VisibleCell* cell = game->getCell(x, y);
+				if ((!cell->clicked) && (!cell->knownMine) && (!cell->isConstrained))
+					cell->mineProbability = blankProbability;
+			}
+		biasUnconstrainedCells(game);
+		move = getMinimumProbabilityCell(game);
+	}
+	if (move != std::tuple<int, int>(-1, -1))
+		lastMove.probability = game->getCell(move)->mineProbability;
+	_minProbX = -1;
+	_minProbY = -1;
+	return move;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// O------------------------------------------------------------------------------O
+// | Portable helpers for the bitset based parts of the engine					  |
+// O------------------------------------------------------------------------------O
+inline int popcount64(uint64_t word)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt64(word);
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+//Index of the lowest set bit; word must not be zero
+inline int trailingZeros64(uint64_t word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (int)index;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
@@ -0,0 +1,207 @@
+#include "CppSweeper.h"
+#include "CppSweeperBits.h"
+#include <array>
+
+//Up to LANE_CELLS cells of the last groups of a component are not branched on: a 64-bit word holds all their assignments,
+//lane l of the word being the assignment whose bit i gives the value of lane cell i
+static const int LANE_CELLS = 6;
+static const uint64_t laneMasks[LANE_CELLS] = { 0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+	0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull };
+
+//Bit-sliced counter of up to 7 set bits per lane: bit b of the count of a lane is bit lane of digits[b]
+struct LaneCounter
+{
+	uint64_t digits[3] = { 0, 0, 0 };
+
+	void add(uint64_t mask)
+	{
+		uint64_t carry = digits[0] & mask;
+		digits[0] ^= mask;
+		uint64_t carry2 = digits[1] & carry;
+		digits[1] ^= carry;
+		digits[2] |= carry2;
+	}
+
+	//The lanes whose count equals value
+	uint64_t equals(int value) const
+	{
+		uint64_t result = ~(uint64_t)0;
+		for (int b = 0; b < 3; b++)
+			result &= ((value >> b) & 1) ? digits[b] : ~digits[b];
+		return result;
+	}
+};
+
+//Depth-first search over the mine counts of the leading groups of a component with the pruning of ComponentEnumerator; at
+//each leaf the cells of the remaining groups are evaluated for all of their assignments at once
+struct BitslicedEnumerator
+{
+	const ComponentConstraints* constraints;
+	std::vector<int> need;
+	std::vector<int> open;
+	std::vector<int> count;
+	int branchGroups = 0;
+	//The cells evaluated in the lanes, laneCells[i] being set in the lanes of laneMasks[i]
+	std::vector<int> laneCells;
+	uint64_t allLanes = 0;
+	//The constraints having lane cells; laneMatches[l][r] holds the lanes in which r lane cells of laneConstraints[l] are mines
+	std::vector<int> laneConstraints;
+	std::vector<std::array<uint64_t, LANE_CELLS + 1>> laneMatches;
+	//laneMines[j]: the lanes in which j lane cells are mines
+	std::vector<uint64_t> laneMines;
+	ComponentSolution* solution;
+	long long nodes = 0;
+	long long maxNodes = 0;
+	long long leaves = 0;
+
+	const std::vector<int>& constraintsOf(int group) { return constraints->constraintsOf[constraints->groups[group][0]]; }
+
+	bool assign(int group, int v)
+	{
+		bool consistent = true;
+		int size = (int)constraints->groups[group].size();
+		count[group] = v;
+		for (int c : constraintsOf(group))
+		{
+			need[c] -= v;
+			open[c] -= size;
+			if ((need[c] < 0) || (need[c] > open[c]))
+				consistent = false;
+		}
+		return consistent;
+	}
+
+	void unassign(int group)
+	{
+		int size = (int)constraints->groups[group].size();
+		for (int c : constraintsOf(group))
+		{
+			need[c] += count[group];
+			open[c] += size;
+		}
+	}
+
+	void evaluateLanes(int mines, double weight)
+	{
+		leaves++;
+		uint64_t valid = allLanes;
+		//need lies between 0 and the number of lane cells of each constraint: the pruning of the branch groups ensures it for the
+		//constraints with branch cells, bitslicedEnumerate checks the others before the search
+		for (unsigned l = 0; (l < laneConstraints.size()) && (valid != 0); l++)
+			valid &= laneMatches[l][need[laneConstraints[l]]];
+		if (valid == 0)
+			return;
+
+		for (unsigned j = 0; j < laneMines.size(); j++)
+		{
+			uint64_t lanes = valid & laneMines[j];
+			if (lanes == 0)
+				continue;
+			int k = mines + (int)j;
+			double lanesWeight = weight * popcount64(lanes);
+			solution->weights[k] += lanesWeight;
+			for (int g = 0; g < branchGroups; g++)
+				if (count[g] > 0)
+				{
+					double share = lanesWeight * count[g] / constraints->groups[g].size();
+					for (int i : constraints->groups[g])
+						solution->cellWeights[i][k] += share;
+				}
+			for (unsigned i = 0; i < laneCells.size(); i++)
+				solution->cellWeights[laneCells[i]][k] += weight * popcount64(lanes & laneMasks[i]);
+		}
+	}
+
+	bool search(int group, int mines, double weight)
+	{
+		if (++nodes > maxNodes)
+			return false;
+		if (group == branchGroups)
+		{
+			evaluateLanes(mines, weight);
+			return true;
+		}
+		int size = (int)constraints->groups[group].size();
+		for (int v = 0; v <= size; v++)
+		{
+			bool consistent = assign(group, v);
+			bool completed = !consistent || search(group + 1, mines + v, weight * binomialTable.values[size][v]);
+			unassign(group);
+			if (!completed)
+				return false;
+		}
+		return true;
+	}
+};
+
+//Enumerates all assignments of a component like enumerateComponent, but evaluates the cells of its last groups (up to
+//LANE_CELLS cells) 64 assignments at a time: the constraint sums of all lanes are formed once with bit-sliced adders, a leaf
+//of the search checks all lanes with one AND per constraint, and the valid lanes are counted by popcount.
+//Returns false if the search needs more than maxNodes nodes.
+bool CppSweeper_AI::bitslicedEnumerate(const ConnectedComponent& component, long long maxNodes, ComponentSolution* solution)
+{
+	int n = (int)component.cellsToSet.size();
+	ComponentConstraints constraints;
+	buildComponentConstraints(component, &constraints);
+
+	BitslicedEnumerator enumerator;
+	enumerator.constraints = &constraints;
+	enumerator.need = constraints.need;
+	for (auto itr = constraints.cellsOf.begin(); itr != constraints.cellsOf.end(); itr++)
+		enumerator.open.push_back((int)itr->size());
+
+	//The groups are ordered so that the last ones share their constraints, which the lanes then close
+	enumerator.branchGroups = (int)constraints.groups.size();
+	while ((enumerator.branchGroups > 0) && (enumerator.laneCells.size() + constraints.groups[enumerator.branchGroups - 1].size() <= LANE_CELLS))
+	{
+		enumerator.branchGroups--;
+		for (int i : constraints.groups[enumerator.branchGroups])
+			enumerator.laneCells.push_back(i);
+	}
+	int laneCount = (int)enumerator.laneCells.size();
+	enumerator.allLanes = (laneCount == LANE_CELLS) ? ~(uint64_t)0 : (((uint64_t)1 << (1 << laneCount)) - 1);
+	std::vector<int> laneOf(n, -1);
+	for (int i = 0; i < laneCount; i++)
+		laneOf[enumerator.laneCells[i]] = i;
+
+	//A constraint on lane cells only is never touched by the search; if it cannot be met the component has no solution
+	bool satisfiable = true;
+	for (unsigned c = 0; c < constraints.need.size(); c++)
+	{
+		LaneCounter counter;
+		int lanes = 0;
+		for (int i : constraints.cellsOf[c])
+			if (laneOf[i] != -1)
+			{
+				counter.add(laneMasks[laneOf[i]]);
+				lanes++;
+			}
+		if (lanes == 0)
+			continue;
+		if ((lanes == (int)constraints.cellsOf[c].size()) && ((constraints.need[c] < 0) || (constraints.need[c] > lanes)))
+			satisfiable = false;
+		std::array<uint64_t, LANE_CELLS + 1> matches;
+		for (int r = 0; r <= LANE_CELLS; r++)
+			matches[r] = counter.equals(r);
+		enumerator.laneConstraints.push_back(c);
+		enumerator.laneMatches.push_back(matches);
+	}
+	LaneCounter mineCounter;
+	for (int i = 0; i < laneCount; i++)
+		mineCounter.add(laneMasks[i]);
+	for (int j = 0; j <= laneCount; j++)
+		enumerator.laneMines.push_back(mineCounter.equals(j));
+
+	solution->cells = component.cellsToSet;
+	solution->weights.assign(n + 1, 0.0);
+	solution->cellWeights.assign(n, std::vector<double>(n + 1, 0.0));
+	if (!satisfiable)
+		return true;
+	enumerator.count.assign(constraints.groups.size(), 0);
+	enumerator.solution = solution;
+	enumerator.maxNodes = maxNodes;
+	bool complete = enumerator.search(0, 0, 1.0);
+	stats_.searchNodes += enumerator.nodes;
+	stats_.leaves += enumerator.leaves;
+	return complete;
+}
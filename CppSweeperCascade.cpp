@@ -0,0 +1,140 @@
+#include "CppSweeper.h"
+#include "CppSweeperTrace.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+//Returns true once the samples of a component settle which is the safest among its cells and a cell of probability target:
+//no interval (Wilson score, cascadeConfidence standard errors wide) of another candidate overlaps that of the safest one, the
+//target counting as exact. The configurations of one search are correlated, so the intervals are too narrow for their nominal
+//confidence, which cascadeConfidence makes up for.
+bool CppSweeper_AI::samplingSettled(const ConnectedComponent* component, double target)
+{
+	double n = (double)component->validLeaves;
+	if (n == 0.0)
+		return false;
+	double z = cascadeConfidence;
+	std::vector<double> lower, upper;
+	for (auto itr = component->cellsToSet.begin(); itr != component->cellsToSet.end(); itr++)
+	{
+		double p = std::min(1.0, std::max(0.0, (*itr)->mineProbability));
+		double center = (p + z * z / (2.0 * n)) / (1.0 + z * z / n);
+		double half = z / (1.0 + z * z / n) * std::sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n));
+		lower.push_back(center - half);
+		upper.push_back(center + half);
+	}
+
+	//The safest candidate is the one of lowest upper bound (best == -1: the target)
+	int best = -1;
+	double bestUpper = target;
+	for (unsigned c = 0; c < upper.size(); c++)
+		if (upper[c] < bestUpper)
+		{
+			best = (int)c;
+			bestUpper = upper[c];
+		}
+	for (unsigned c = 0; c < lower.size(); c++)
+		if (((int)c != best) && (lower[c] < bestUpper))
+			return false;
+	return true;
+}
+
+//Escalates from cheap to expensive estimates only where they are needed. Tier 1 solves the components of at most
+//exactFastPathCells cells exactly, tier 2 tries the larger ones with the exact solvers limited to cascadeMaxNodes (the frontier
+//DP still solves long chains), and only the components left are sampled (tier 3), each until it is settled whether it holds a
+//cell safer than the safest one known so far. The exact components are combined with the mines the sampled ones are expected
+//to hold, so the probabilities are exact whenever no component needs sampling.
+std::tuple<int, int> CppSweeper_AI::stochasticMove_cascade(CppSweeper* game)
+{
+	std::vector<VisibleCell*> boundary;
+	std::vector<VisibleCell*> cellsToSet;
+	{
+		TRACE_SCOPE("label components");
+		PhaseTimer timer(stats_.labelTime);
+		collectBoundary(game, &boundary, &cellsToSet);
+		labelConnectedComponents(game, &cellsToSet, &boundary);
+	}
+	samplesCurrentCycle_ = 0;
+	totalSamples_ = 0;
+	_minProbX = -1;
+	_minProbY = -1;
+
+	//The components stay in label order, as the search counts the samples of a component at components[label]
+	std::vector<unsigned> order(components.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](unsigned a, unsigned b) { return components[a].cellsToSet.size() < components[b].cellsToSet.size(); });
+	stats_.components = (int)components.size();
+	stats_.constrainedCells = (int)cellsToSet.size();
+	if (order.size() > 0)
+		stats_.largestComponent = (int)components[order.back()].cellsToSet.size();
+
+	//Tiers 1 and 2
+	std::vector<ComponentSolution> solutions;
+	std::vector<unsigned> unsolved;
+	{
+		TRACE_SCOPE("exact components");
+		PhaseTimer timer(stats_.searchTime);
+		for (unsigned i : order)
+		{
+			ComponentSolution solution;
+			long long budget = ((int)components[i].cellsToSet.size() <= exactFastPathCells) ? exactMaxNodes : cascadeMaxNodes;
+			if (solveComponent(components[i], budget, &solution))
+				solutions.push_back(std::move(solution));
+			else
+				unsolved.push_back(i);
+		}
+	}
+
+	//Until they are sampled, the unsolved components are assumed to hold mines at the density of all covered cells
+	int remainingMines = game->mineCount - knownMines;
+	int coveredCells = game->width * game->height - knownMines - game->uncoveredCells();
+	double density = (coveredCells > 0) ? (double)remainingMines / coveredCells : 0.0;
+	double outsideMines = 0.0;
+	for (unsigned i : unsolved)
+		outsideMines += density * components[i].cellsToSet.size();
+	{
+		PhaseTimer timer(stats_.probabilityTime);
+		combineSolutions(game, &solutions, (int)std::lround(outsideMines));
+		biasUnconstrainedCells(game);
+	}
+
+	//Tier 3
+	if (unsolved.size() > 0)
+	{
+		std::vector<bool> sampled(components.size(), false);
+		for (unsigned i : unsolved)
+			sampled[i] = true;
+		double target = 1.0;
+		for (int x = 0; x < game->width; x++)
+			for (int y = 0; y < game->height; y++)
+			{
+				VisibleCell* cell = game->getCell(x, y);
+				if ((!cell->clicked) && (!cell->knownMine) && ((cell->connectedComponent == -1) || (!sampled[cell->connectedComponent])))
+					target = std::min(target, cell->mineProbability);
+			}
+		outsideMines = 0.0;
+		for (unsigned i : unsolved)
+		{
+			sampleComponent(game, &components[i], target);
+			for (auto itr = components[i].cellsToSet.begin(); itr != components[i].cellsToSet.end(); itr++)
+			{
+				target = std::min(target, (*itr)->mineProbability);
+				outsideMines += (*itr)->mineProbability;
+			}
+		}
+		PhaseTimer timer(stats_.probabilityTime);
+		combineSolutions(game, &solutions, (int)std::lround(outsideMines));
+		biasUnconstrainedCells(game);
+	}
+
+	std::tuple<int, int> move;
+	{
+		PhaseTimer timer(stats_.probabilityTime);
+		move = getMinimumProbabilityCell(game);
+	}
+	if (move != std::tuple<int, int>(-1, -1))
+		lastMove.probability = game->getCell(move)->mineProbability;
+	_minProbX = -1;
+	_minProbY = -1;
+	return move;
+}
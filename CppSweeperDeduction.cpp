@@ -0,0 +1,639 @@
+#include "CppSweeper.h"
+#include "CppSweeperBits.h"
+#include "CppSweeperTiles.h"
+#include "CppSweeperTrace.h"
+#include <algorithm>
+#include <unordered_set>
+
+//Adds the result of a deduction stage to the engine's knowledge: mines are marked as known and removed from all knowledge items,
+//safe cells are stored as knowledge data with a mine count of zero (and will hence be picked up by knownSafeMove)
+void CppSweeper_AI::applyDeductions(const std::vector<VisibleCell*>& safeCells, const std::vector<VisibleCell*>& mineCells)
+{
+	{
+		TRACE_SCOPE("lock wait");
+		while (!m->try_lock());
+	}
+	for (auto itr = mineCells.begin(); itr != mineCells.end(); itr++)
+	{
+		VisibleCell* mineCell = *itr;
+		if (mineCell->knownMine)
+			continue;
+		mineCell->knownMine = true;
+		mineCell->mineProbability = 1.0f;
+		knownMines++;
+
+		//The reduction step of updateKnowledge - the mine can be removed from all sets of knowledge
+		auto it = knowledge.begin();
+		while (it != knowledge.end())
+		{
+			auto pos = std::find(it->neighbouringCells.begin(), it->neighbouringCells.end(), mineCell);
+			if (pos != it->neighbouringCells.end())
+			{
+				it->neighbouringCells.erase(pos);
+				it->mineCount--;
+			}
+			if (it->neighbouringCells.size() == 0)
+				it = knowledge.erase(it);
+			else
+				it++;
+		}
+	}
+
+	//One datum per safe cell - single cell data are left alone by the subset deduction of updateKnowledge, which would otherwise
+	//keep deriving complements from a shrinking safe set on every click
+	for (auto itr = safeCells.begin(); itr != safeCells.end(); itr++)
+	{
+		KnowledgeDatum kd;
+		kd.x = (*itr)->x;
+		kd.y = (*itr)->y;
+		kd.mineCount = 0;
+		kd.neighbouringCells.push_back(*itr);
+		knowledge.push_back(kd);
+	}
+	m->unlock();
+}
+
+// O------------------------------------------------------------------------------O
+// | The local pattern table. A window consists of three revealed cells N0-N2	  |
+// | along a wall and the five cells C0-C4 in front of them, where Ni touches	  |
+// | Ci, Ci+1 and Ci+2 (this covers 1-2-1, 1-2-2-1 and the corner 1-1 among		  |
+// | others). The key packs the remaining mine count of each Ni (2 bits each)	  |
+// | and the mask of Cj that are still undetermined (5 bits). Each entry holds	  |
+// | the mask of cells that are safe in every consistent assignment (bits 0-4)	  |
+// | and the mask of cells that are mines in every one (bits 5-9).				  |
+// O------------------------------------------------------------------------------O
+const int PATTERN_KEYS = 1 << 11;
+
+struct PatternTable
+{
+	uint16_t entries[PATTERN_KEYS];
+};
+
+constexpr PatternTable generatePatternTable()
+{
+	PatternTable table{};
+	for (int key = 0; key < PATTERN_KEYS; key++)
+	{
+		int undetermined = key >> 6;
+		int mineAlways = 0x1F;
+		int mineSometimes = 0;
+		bool consistent = false;
+		for (int mines = 0; mines < 32; mines++)
+		{
+			if (mines & ~undetermined)
+				continue;
+			bool valid = true;
+			for (int i = 0; i < 3; i++)
+			{
+				int window = (mines >> i) & 7;
+				int count = (window & 1) + ((window >> 1) & 1) + ((window >> 2) & 1);
+				if (count != ((key >> (2 * i)) & 3))
+					valid = false;
+			}
+			if (!valid)
+				continue;
+			consistent = true;
+			mineAlways &= mines;
+			mineSometimes |= mines;
+		}
+		if (consistent)
+			table.entries[key] = (uint16_t)((undetermined & ~mineSometimes) | (mineAlways << 5));
+	}
+	return table;
+}
+
+constexpr PatternTable patternTable = generatePatternTable();
+
+//Looks up the window with middle cell (cx,cy), running along (ax,ay) with the cells C0-C4 on the side (nx,ny).
+//Returns false if the window does not apply, i.e. one of N0-N2 is not revealed or has undetermined neighbours outside of C0-C4.
+static bool lookupPattern(CppSweeper* game, int cx, int cy, int ax, int ay, int nx, int ny, VisibleCell* window[5], uint16_t& entry)
+{
+	int key = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		int x = cx + (i - 1) * ax;
+		int y = cy + (i - 1) * ay;
+		if ((x < 0) || (y < 0) || (x >= game->width) || (y >= game->height))
+			return false;
+		VisibleCell* cell = game->getCell(x, y);
+		if ((!cell->clicked) || (cell->mine))
+			return false;
+
+		int remainingMines = cell->neighbouringMines;
+		for (auto itr = cell->neighbouringCells.begin(); itr != cell->neighbouringCells.end(); itr++)
+		{
+			if ((*itr)->knownMine)
+				remainingMines--;
+			else if (!(*itr)->clicked)
+			{
+				int along = ((*itr)->x - cx) * ax + ((*itr)->y - cy) * ay;
+				int side = ((*itr)->x - cx) * nx + ((*itr)->y - cy) * ny;
+				if ((side != 1) || (along < -2) || (along > 2))
+					return false;
+			}
+		}
+		if ((remainingMines < 0) || (remainingMines > 3))
+			return false;
+		key |= remainingMines << (2 * i);
+	}
+
+	for (int j = 0; j < 5; j++)
+	{
+		int x = cx + (j - 2) * ax + nx;
+		int y = cy + (j - 2) * ay + ny;
+		window[j] = nullptr;
+		if ((x >= 0) && (y >= 0) && (x < game->width) && (y < game->height))
+		{
+			VisibleCell* cell = game->getCell(x, y);
+			if ((!cell->clicked) && (!cell->knownMine))
+			{
+				window[j] = cell;
+				key |= 1 << (6 + j);
+			}
+		}
+	}
+	entry = patternTable.entries[key];
+	return true;
+}
+
+//Matches the local pattern table against all windows that can have changed since the last call, i.e. those within
+//two cells of a newly revealed cell. The deductions are added to knowledge and the number of safe cells is returned.
+//On a tiled board each tile matches the windows centred in its columns.
+int CppSweeper_AI::patternDeduction(CppSweeper* game)
+{
+	//Window orientations: axis (ax,ay) and side (nx,ny)
+	const int orientations[4][4] = { { 1, 0, 0, 1 }, { 1, 0, 0, -1 }, { 0, 1, 1, 0 }, { 0, 1, -1, 0 } };
+
+	std::vector<char> visited(game->width * game->height, false);
+	int count = tiles(game);
+	BoardTiles columns(game->width, count);
+	std::vector<std::vector<VisibleCell*>> tileSafe(count);
+	std::vector<std::vector<VisibleCell*>> tileMines(count);
+	std::vector<long long> tileHits(count, 0);
+	runTiles(count, [&](int tile) {
+		std::vector<VisibleCell*>& safeCells = tileSafe[tile];
+		std::vector<VisibleCell*>& mineCells = tileMines[tile];
+		for (auto itr = revealedCells.begin(); itr != revealedCells.end(); itr++)
+			for (int cx = std::max((*itr)->x - 2, columns.begin(tile)); cx <= std::min((*itr)->x + 2, columns.end(tile) - 1); cx++)
+				for (int cy = std::max((*itr)->y - 2, 0); cy <= std::min((*itr)->y + 2, game->height - 1); cy++)
+				{
+					if (visited[cx + cy * game->width])
+						continue;
+					visited[cx + cy * game->width] = true;
+					for (int o = 0; o < 4; o++)
+					{
+						VisibleCell* window[5];
+						uint16_t entry;
+						if ((!lookupPattern(game, cx, cy, orientations[o][0], orientations[o][1], orientations[o][2], orientations[o][3], window, entry)) || (entry == 0))
+							continue;
+						tileHits[tile]++;
+						for (int j = 0; j < 5; j++)
+						{
+							if ((entry >> j) & 1)
+							{
+								if (std::find(safeCells.begin(), safeCells.end(), window[j]) == safeCells.end())
+									safeCells.push_back(window[j]);
+							}
+							else if (((entry >> (5 + j)) & 1) && (std::find(mineCells.begin(), mineCells.end(), window[j]) == mineCells.end()))
+								mineCells.push_back(window[j]);
+						}
+					}
+				}
+	});
+	revealedCells.clear();
+
+	//Windows of different tiles can overlap in the cells they deduce
+	std::vector<VisibleCell*> safeCells;
+	std::vector<VisibleCell*> mineCells;
+	if (count == 1)
+	{
+		safeCells.swap(tileSafe[0]);
+		mineCells.swap(tileMines[0]);
+	}
+	else
+	{
+		std::unordered_set<VisibleCell*> listed;
+		for (int tile = 0; tile < count; tile++)
+		{
+			for (auto itr = tileSafe[tile].begin(); itr != tileSafe[tile].end(); itr++)
+				if (listed.insert(*itr).second)
+					safeCells.push_back(*itr);
+			for (auto itr = tileMines[tile].begin(); itr != tileMines[tile].end(); itr++)
+				if (listed.insert(*itr).second)
+					mineCells.push_back(*itr);
+		}
+	}
+	for (int tile = 0; tile < count; tile++)
+		stats_.patternHits += tileHits[tile];
+
+	if ((safeCells.size() > 0) || (mineCells.size() > 0))
+		applyDeductions(safeCells, mineCells);
+	return (int)safeCells.size();
+}
+
+//Builds one cardinality constraint per clicked cell over its covered neighbours that are not known to be mines.
+//The covered cells are numbered in the order they are found (the frontier), and each one watches the constraints it occurs in.
+//On a tiled board each tile builds the constraints of its columns over board positions, which are then numbered in column
+//order, as without tiles.
+void CppSweeper_AI::buildPropagationConstraints(CppSweeper* game)
+{
+	frontier.clear();
+	constraints.clear();
+	watches.clear();
+	trail.clear();
+	agenda.clear();
+	frontierIndex.assign(game->width * game->height, -1);
+
+	int count = tiles(game);
+	BoardTiles columns(game->width, count);
+	std::vector<std::vector<PropagationConstraint>> tileConstraints(count);
+	runTiles(count, [&](int tile) {
+		for (int x = columns.begin(tile); x < columns.end(tile); x++)
+			for (int y = 0; y < game->height; y++)
+			{
+				VisibleCell* cell = game->getCell(x, y);
+				if ((!cell->clicked) || (cell->neighbouringMines == 0))
+					continue;
+
+				PropagationConstraint constraint;
+				constraint.mineCount = cell->neighbouringMines;
+				for (auto itr = cell->neighbouringCells.begin(); itr != cell->neighbouringCells.end(); itr++)
+				{
+					if ((*itr)->knownMine)
+						constraint.mineCount--;
+					else if (!(*itr)->clicked)
+						constraint.cells.push_back((*itr)->x + (*itr)->y * game->width);
+				}
+				if (constraint.cells.size() > 0)
+					tileConstraints[tile].push_back(constraint);
+			}
+	});
+
+	for (int tile = 0; tile < count; tile++)
+		for (auto constraint = tileConstraints[tile].begin(); constraint != tileConstraints[tile].end(); constraint++)
+		{
+			for (auto itr = constraint->cells.begin(); itr != constraint->cells.end(); itr++)
+			{
+				int& index = frontierIndex[*itr];
+				if (index == -1)
+				{
+					index = (int)frontier.size();
+					frontier.push_back(game->getCell(*itr % game->width, *itr / game->width));
+					watches.emplace_back();
+				}
+				*itr = index;
+				watches[index].push_back((int)constraints.size());
+			}
+			constraint->unassigned = (int)constraint->cells.size();
+			constraints.push_back(*constraint);
+		}
+
+	assignment.assign(frontier.size(), -1);
+	onAgenda.assign(constraints.size(), false);
+}
+
+//Assigns value (0: safe, 1: mine) to a frontier cell and updates the watched counters of its constraints.
+//Constraints that became unit (all remaining cells safe or all mines) are put on the agenda.
+//Returns false if one of the constraints can no longer be satisfied.
+bool CppSweeper_AI::assign(int cell, signed char value)
+{
+	assignment[cell] = value;
+	trail.push_back(cell);
+	bool consistent = true;
+	for (auto itr = watches[cell].begin(); itr != watches[cell].end(); itr++)
+	{
+		PropagationConstraint& constraint = constraints[*itr];
+		constraint.unassigned--;
+		constraint.assignedMines += value;
+		int remainingMines = constraint.mineCount - constraint.assignedMines;
+		if ((remainingMines < 0) || (remainingMines > constraint.unassigned))
+			consistent = false;
+		else if ((constraint.unassigned > 0) && ((remainingMines == 0) || (remainingMines == constraint.unassigned)) && (!onAgenda[*itr]))
+		{
+			agenda.push_back(*itr);
+			onAgenda[*itr] = true;
+		}
+	}
+	return consistent;
+}
+
+//Runs the agenda to a fixpoint, applying the "all safe" and "all mines" rules. Returns false on a contradiction.
+bool CppSweeper_AI::propagate()
+{
+	while (agenda.size() > 0)
+	{
+		int index = agenda.back();
+		agenda.pop_back();
+		onAgenda[index] = false;
+
+		PropagationConstraint& constraint = constraints[index];
+		int remainingMines = constraint.mineCount - constraint.assignedMines;
+		if ((remainingMines < 0) || (remainingMines > constraint.unassigned))
+			return false;
+		if (constraint.unassigned == 0)
+			continue;
+
+		signed char value;
+		if (remainingMines == 0)
+			value = 0;
+		else if (remainingMines == constraint.unassigned)
+			value = 1;
+		else
+			continue;
+
+		for (auto itr = constraint.cells.begin(); itr != constraint.cells.end(); itr++)
+			if ((assignment[*itr] == -1) && (!assign(*itr, value)))
+				return false;
+	}
+	return true;
+}
+
+//Reverts all assignments made after the trail had length trailSize, and drops the pending agenda
+void CppSweeper_AI::undoTrail(size_t trailSize)
+{
+	while (trail.size() > trailSize)
+	{
+		int cell = trail.back();
+		trail.pop_back();
+		for (auto itr = watches[cell].begin(); itr != watches[cell].end(); itr++)
+		{
+			constraints[*itr].unassigned++;
+			constraints[*itr].assignedMines -= assignment[cell];
+		}
+		assignment[cell] = -1;
+	}
+	for (auto itr = agenda.begin(); itr != agenda.end(); itr++)
+		onAgenda[*itr] = false;
+	agenda.clear();
+}
+
+//Deduces safe cells and mines from the constraints imposed by the clicked cells, in the style of a SAT solver:
+//unit propagation to a fixpoint, followed by bounded failed-literal probing (if assuming a cell to be a mine leads to a contradiction,
+//it is safe and vice versa). The results are added to knowledge; the number of safe cells found is returned.
+int CppSweeper_AI::unitPropagation(CppSweeper* game)
+{
+	buildPropagationConstraints(game);
+	for (unsigned i = 0; i < constraints.size(); i++)
+	{
+		agenda.push_back(i);
+		onAgenda[i] = true;
+	}
+	if (!propagate())
+		return 0;
+
+	int probes = 0;
+	bool progress = true;
+	while ((progress) && (probes < maxProbes))
+	{
+		progress = false;
+		for (int cell = 0; (cell < (int)frontier.size()) && (probes < maxProbes); cell++)
+		{
+			if (assignment[cell] != -1)
+				continue;
+			//Probe the mine assumption first, as safe cells are what the engine is looking for
+			for (signed char value = 1; value >= 0; value--)
+			{
+				probes++;
+				size_t trailSize = trail.size();
+				bool consistent = assign(cell, value) && propagate();
+				undoTrail(trailSize);
+				if (!consistent)
+				{
+					//Failed literal - the opposite value is forced. If that fails too, the board is inconsistent with the engine's view.
+					if (!assign(cell, 1 - value) || !propagate())
+						return 0;
+					progress = true;
+					break;
+				}
+			}
+		}
+	}
+
+	std::vector<VisibleCell*> safeCells;
+	std::vector<VisibleCell*> mineCells;
+	for (unsigned i = 0; i < frontier.size(); i++)
+	{
+		if (assignment[i] == 0)
+			safeCells.push_back(frontier[i]);
+		else if ((assignment[i] == 1) && (!frontier[i]->knownMine))
+			mineCells.push_back(frontier[i]);
+	}
+	if ((safeCells.size() > 0) || (mineCells.size() > 0))
+		applyDeductions(safeCells, mineCells);
+	return (int)safeCells.size();
+}
+
+//Reduces the frontier constraint system (one row per clicked cell, one column per covered cell) to row echelon form.
+//Rows are bitsets, so each elimination step is a handful of word operations per 64 columns. An elimination that would produce
+//a coefficient of +-2 is skipped, which leaves the row a valid (if less reduced) consequence of the constraints.
+//Each reduced row bounds its value by -(negative coefficients) and +(positive coefficients); a row that meets one of the bounds
+//forces all of its cells. The deductions are added to knowledge and the number of safe cells is returned.
+//The pivot structure is kept in reduction and used by stochasticMove_BoundaryBacktracking to avoid branching on pivot cells.
+int CppSweeper_AI::gaussianDeduction(CppSweeper* game)
+{
+	buildPropagationConstraints(game);
+	reduction = GaussianReduction();
+	if ((frontier.size() == 0) || ((int)frontier.size() > gaussianMaxCells))
+		return 0;
+
+	int columns = (int)frontier.size();
+	int words = (columns + 63) / 64;
+	reduction.cells = frontier;
+	reduction.columnOf = frontierIndex;
+	reduction.width = game->width;
+	reduction.isPivot.assign(columns, false);
+
+	std::vector<ConstraintRow>& rows = reduction.rows;
+	for (auto itr = constraints.begin(); itr != constraints.end(); itr++)
+	{
+		ConstraintRow row;
+		row.positive.assign(words, 0);
+		row.negative.assign(words, 0);
+		row.value = itr->mineCount;
+		for (auto itr2 = itr->cells.begin(); itr2 != itr->cells.end(); itr2++)
+			row.positive[*itr2 / 64] |= 1ULL << (*itr2 % 64);
+		rows.push_back(row);
+	}
+
+	int pivotRow = 0;
+	for (int column = 0; (column < columns) && (pivotRow < (int)rows.size()); column++)
+	{
+		int word = column / 64;
+		uint64_t bit = 1ULL << (column % 64);
+
+		int found = -1;
+		for (int r = pivotRow; r < (int)rows.size(); r++)
+			if ((rows[r].positive[word] | rows[r].negative[word]) & bit)
+			{
+				found = r;
+				break;
+			}
+		if (found == -1)
+			continue;
+		std::swap(rows[pivotRow], rows[found]);
+
+		//Normalise the pivot row to a coefficient of +1 at the pivot column
+		ConstraintRow& pivot = rows[pivotRow];
+		if (pivot.negative[word] & bit)
+		{
+			std::swap(pivot.positive, pivot.negative);
+			pivot.value = -pivot.value;
+		}
+
+		for (int r = 0; r < (int)rows.size(); r++)
+		{
+			ConstraintRow& row = rows[r];
+			if ((r == pivotRow) || !((row.positive[word] | row.negative[word]) & bit))
+				continue;
+
+			//row += sign * pivot, with sign chosen to cancel the pivot column
+			bool subtract = (row.positive[word] & bit) != 0;
+			const std::vector<uint64_t>& addPositive = subtract ? pivot.negative : pivot.positive;
+			const std::vector<uint64_t>& addNegative = subtract ? pivot.positive : pivot.negative;
+
+			bool overflow = false;
+			for (int w = 0; w < words; w++)
+				if ((row.positive[w] & addPositive[w]) | (row.negative[w] & addNegative[w]))
+				{
+					overflow = true;
+					break;
+				}
+			if (overflow)
+			{
+				reduction.complete = false;
+				continue;
+			}
+
+			for (int w = 0; w < words; w++)
+			{
+				uint64_t cancelled = (row.positive[w] & addNegative[w]) | (row.negative[w] & addPositive[w]);
+				row.positive[w] = (row.positive[w] | addPositive[w]) & ~cancelled;
+				row.negative[w] = (row.negative[w] | addNegative[w]) & ~cancelled;
+			}
+			row.value += subtract ? -pivot.value : pivot.value;
+		}
+
+		reduction.pivotColumns.push_back(column);
+		reduction.isPivot[column] = true;
+		pivotRow++;
+	}
+
+	//Extract the cells forced by the 0/1 bounds on each reduced row
+	std::vector<signed char> forced(columns, -1);
+	for (auto itr = rows.begin(); itr != rows.end(); itr++)
+	{
+		int positiveCount = 0;
+		int negativeCount = 0;
+		for (int w = 0; w < words; w++)
+		{
+			positiveCount += popcount64(itr->positive[w]);
+			negativeCount += popcount64(itr->negative[w]);
+		}
+		if (positiveCount + negativeCount == 0)
+			continue;
+
+		signed char positiveValue;
+		if (itr->value == positiveCount)
+			positiveValue = 1;
+		else if (itr->value == -negativeCount)
+			positiveValue = 0;
+		else
+			continue;
+
+		for (int w = 0; w < words; w++)
+		{
+			for (uint64_t bits = itr->positive[w]; bits != 0; bits &= bits - 1)
+				forced[w * 64 + trailingZeros64(bits)] = positiveValue;
+			for (uint64_t bits = itr->negative[w]; bits != 0; bits &= bits - 1)
+				forced[w * 64 + trailingZeros64(bits)] = 1 - positiveValue;
+		}
+	}
+
+	std::vector<VisibleCell*> safeCells;
+	std::vector<VisibleCell*> mineCells;
+	for (int column = 0; column < columns; column++)
+	{
+		if (forced[column] == -1)
+			continue;
+		if (forced[column] == 0)
+			safeCells.push_back(frontier[column]);
+		else if (!frontier[column]->knownMine)
+			mineCells.push_back(frontier[column]);
+
+		//Substitute the forced value into the reduced rows, so that they only refer to undetermined cells
+		int word = column / 64;
+		uint64_t bit = 1ULL << (column % 64);
+		for (auto itr = rows.begin(); itr != rows.end(); itr++)
+		{
+			if (itr->positive[word] & bit)
+				itr->value -= forced[column];
+			else if (itr->negative[word] & bit)
+				itr->value += forced[column];
+			itr->positive[word] &= ~bit;
+			itr->negative[word] &= ~bit;
+		}
+	}
+	if ((safeCells.size() > 0) || (mineCells.size() > 0))
+		applyDeductions(safeCells, mineCells);
+	return (int)safeCells.size();
+}
+
+//Determines for each reduced row the cell of cellsToSet that is set last by boundaryBacktracking. Once the search reaches that
+//cell, all other cells of the row have been set and its value follows from the row (cf. forcedValue).
+void CppSweeper_AI::prepareForcedCells(std::vector<VisibleCell*>* cellsToSet)
+{
+	rowPositions.assign(reduction.cells.size(), -1);
+	for (unsigned i = 0; i < cellsToSet->size(); i++)
+	{
+		VisibleCell* cell = cellsToSet->at(i);
+		cell->forcedRow = -1;
+		if (reduction.columnOf.size() > 0)
+		{
+			int column = reduction.columnOf[cell->x + cell->y * reduction.width];
+			if (column != -1)
+				rowPositions[column] = i;
+		}
+	}
+
+	for (unsigned r = 0; r < reduction.rows.size(); r++)
+	{
+		const ConstraintRow& row = reduction.rows[r];
+		int lastPosition = -1;
+		bool inComponent = true;
+		for (unsigned w = 0; (w < row.positive.size()) && inComponent; w++)
+			for (uint64_t bits = row.positive[w] | row.negative[w]; bits != 0; bits &= bits - 1)
+			{
+				int position = rowPositions[w * 64 + trailingZeros64(bits)];
+				if (position == -1)
+				{
+					inComponent = false;
+					break;
+				}
+				lastPosition = std::max(lastPosition, position);
+			}
+		if ((inComponent) && (lastPosition != -1) && (cellsToSet->at(lastPosition)->forcedRow == -1))
+			cellsToSet->at(lastPosition)->forcedRow = r;
+	}
+}
+
+//Returns the value of cell implied by its forced row and the simulated mines of the other cells in the row.
+//Any result other than 0 or 1 means that the current partial configuration is inconsistent.
+int CppSweeper_AI::forcedValue(VisibleCell* cell)
+{
+	const ConstraintRow& row = reduction.rows[cell->forcedRow];
+	int column = reduction.columnOf[cell->x + cell->y * reduction.width];
+	int value = row.value;
+	for (unsigned w = 0; w < row.positive.size(); w++)
+	{
+		for (uint64_t bits = row.positive[w]; bits != 0; bits &= bits - 1)
+			if (reduction.cells[w * 64 + trailingZeros64(bits)]->simMine)
+				value--;
+		for (uint64_t bits = row.negative[w]; bits != 0; bits &= bits - 1)
+			if (reduction.cells[w * 64 + trailingZeros64(bits)]->simMine)
+				value++;
+	}
+	//Undo the contribution of cell itself, then divide by its coefficient (+-1)
+	if (row.positive[column / 64] & (1ULL << (column % 64)))
+		return cell->simMine ? value + 1 : value;
+	return cell->simMine ? -(value - 1) : -value;
+}
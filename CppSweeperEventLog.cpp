@@ -0,0 +1,153 @@
+#include "CppSweeperEventLog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static const char eventMagic[4] = { 'C', 'S', 'E', 'L' };
+static const uint32_t eventVersion = 1;
+static const uint32_t byteOrderMark = 0x01020304;
+
+bool SweeperEventLog::open(const std::string& path)
+{
+	close();
+	file_ = fopen(path.c_str(), "wb");
+	if (file_ == nullptr)
+		return false;
+	uint32_t header[4];
+	std::memcpy(&header[0], eventMagic, 4);
+	header[1] = eventVersion;
+	header[2] = (uint32_t)sizeof(SweeperEvent);
+	header[3] = byteOrderMark;
+	if (fwrite(header, sizeof(header), 1, file_) != 1)
+	{
+		fclose(file_);
+		file_ = nullptr;
+		return false;
+	}
+	int rounded = 1;
+	while (rounded < capacity)
+		rounded <<= 1;
+	capacity = rounded;
+	{
+		std::lock_guard<std::mutex> lock(writersMutex_);
+		writers_.clear();
+	}
+	written_ = 0;
+	failed_ = false;
+	stop_ = false;
+	pending_.clear();
+	pending_.reserve(flushEvents + capacity);
+	thread_ = std::thread(&SweeperEventLog::work, this);
+	return true;
+}
+
+bool SweeperEventLog::close()
+{
+	if (file_ == nullptr)
+		return true;
+	{
+		std::lock_guard<std::mutex> lock(stopMutex_);
+		stop_ = true;
+	}
+	stopped_.notify_all();
+	thread_.join();
+	bool ok = !failed_;
+	ok &= (fclose(file_) == 0);
+	file_ = nullptr;
+	return ok;
+}
+
+SweeperEventLog::Writer* SweeperEventLog::writer()
+{
+	std::lock_guard<std::mutex> lock(writersMutex_);
+	writers_.emplace_back(new Writer(capacity));
+	return writers_.back().get();
+}
+
+uint64_t SweeperEventLog::dropped()
+{
+	std::lock_guard<std::mutex> lock(writersMutex_);
+	uint64_t dropped = 0;
+	for (auto itr = writers_.begin(); itr != writers_.end(); itr++)
+		dropped += (*itr)->dropped_.load(std::memory_order_relaxed);
+	return dropped;
+}
+
+size_t SweeperEventLog::drain()
+{
+	size_t drained = 0;
+	std::lock_guard<std::mutex> lock(writersMutex_);
+	for (auto itr = writers_.begin(); itr != writers_.end(); itr++)
+	{
+		Writer* writer = itr->get();
+		uint64_t tail = writer->tail_.load(std::memory_order_relaxed);
+		uint64_t head = writer->head_.load(std::memory_order_acquire);
+		if (head == tail)
+			continue;
+		//The events between tail and head, in at most two pieces if they wrap around the end of the ring
+		size_t first = (size_t)(tail & writer->mask_);
+		size_t count = (size_t)(head - tail);
+		size_t piece = std::min(count, writer->ring_.size() - first);
+		pending_.insert(pending_.end(), writer->ring_.begin() + first, writer->ring_.begin() + first + piece);
+		pending_.insert(pending_.end(), writer->ring_.begin(), writer->ring_.begin() + (count - piece));
+		writer->tail_.store(head, std::memory_order_release);
+		drained += count;
+	}
+	return drained;
+}
+
+void SweeperEventLog::flush()
+{
+	if (pending_.size() == 0)
+		return;
+	if (!failed_ && (fwrite(pending_.data(), sizeof(SweeperEvent), pending_.size(), file_) == pending_.size()))
+		written_ += pending_.size();
+	else
+		failed_ = true;
+	pending_.clear();
+}
+
+void SweeperEventLog::work()
+{
+	std::unique_lock<std::mutex> lock(stopMutex_);
+	while (!stop_)
+	{
+		lock.unlock();
+		size_t drained = drain();
+		if ((int)pending_.size() >= flushEvents)
+			flush();
+		lock.lock();
+		//Keep emptying the rings while the games produce events; otherwise write what there is and wait
+		if ((drained == 0) && !stop_)
+		{
+			lock.unlock();
+			flush();
+			lock.lock();
+			stopped_.wait_for(lock, std::chrono::milliseconds(intervalMs), [this] { return stop_; });
+		}
+	}
+	lock.unlock();
+	drain();
+	flush();
+	fflush(file_);
+}
+
+bool SweeperEventLog::read(const std::string& path, std::vector<SweeperEvent>* events)
+{
+	events->clear();
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	uint32_t header[4];
+	bool valid = (fread(header, sizeof(header), 1, file) == 1) && (std::memcmp(&header[0], eventMagic, 4) == 0) && (header[1] == eventVersion) &&
+		(header[2] == sizeof(SweeperEvent)) && (header[3] == byteOrderMark);
+	if (valid)
+	{
+		SweeperEvent buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, sizeof(SweeperEvent), 4096, file)) > 0)
+			events->insert(events->end(), buffer, buffer + read);
+	}
+	fclose(file);
+	return valid;
+}
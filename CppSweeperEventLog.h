@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class EventOutcome : uint8_t { OUTCOME_CONTINUE = 0, OUTCOME_WON = 1, OUTCOME_LOST = 2 };
+
+// O------------------------------------------------------------------------------O
+// | One move of a game as written to an event log.								  |
+// O------------------------------------------------------------------------------O
+struct SweeperEvent
+{
+	//The caller's id of the game, e.g. its seed
+	uint64_t game;
+	//The number of the move in its game, from 1
+	uint32_t moveNo;
+	//Estimated mine probability of the cell, 0 for a deduced move
+	float probability;
+	//Engine time of the move, in microseconds
+	float solveTime;
+	int16_t x;
+	int16_t y;
+	//A MoveType value
+	uint8_t moveType;
+	//An EventOutcome value: the state of the game after the cell was clicked
+	uint8_t outcome;
+	//The caller's tag, e.g. the engine configuration
+	uint16_t tag;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(SweeperEvent) == 32, "events are written as fixed-size records");
+
+// O------------------------------------------------------------------------------O
+// | Binary log of the moves of many games played on many threads. Each thread	  |
+// | appends to a ring buffer of its own (a Writer) without locking or waiting;	  |
+// | a background thread empties the rings into large sequential writes. When	  |
+// | a ring is full the event is dropped and counted instead, so that a slow	  |
+// | disk never holds up the games. File layout (byte order of the machine		  |
+// | writing it, given by the byte order mark):									  |
+// |   header:  "CSEL", uint32 version, uint32 record size, uint32 byte order	  |
+// |            mark 0x01020304												  |
+// |   records: SweeperEvent, in the order they were emptied from the rings,	  |
+// |            which is the order of appending for each thread					  |
+// O------------------------------------------------------------------------------O
+class SweeperEventLog
+{
+public:
+	// O------------------------------------------------------------------------------O
+	// | The ring of one thread; append must only be called from that thread.		  |
+	// O------------------------------------------------------------------------------O
+	class Writer
+	{
+		friend class SweeperEventLog;
+	private:
+		std::vector<SweeperEvent> ring_;
+		uint64_t mask_;
+		//head_ is advanced by the appending thread, tail_ by the background thread
+		alignas(64) std::atomic<uint64_t> head_{ 0 };
+		alignas(64) std::atomic<uint64_t> tail_{ 0 };
+		std::atomic<uint64_t> dropped_{ 0 };
+		explicit Writer(int capacity) : ring_(capacity), mask_((uint64_t)capacity - 1) {}
+	public:
+		//Returns false if the ring was full and the event was dropped
+		bool append(const SweeperEvent& event)
+		{
+			uint64_t head = head_.load(std::memory_order_relaxed);
+			if (head - tail_.load(std::memory_order_acquire) > mask_)
+			{
+				dropped_.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			ring_[head & mask_] = event;
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+	};
+private:
+	FILE* file_ = nullptr;
+	std::vector<std::unique_ptr<Writer>> writers_;
+	std::mutex writersMutex_;
+	std::thread thread_;
+	std::mutex stopMutex_;
+	std::condition_variable stopped_;
+	bool stop_ = false;
+	std::vector<SweeperEvent> pending_;
+	std::atomic<uint64_t> written_{ 0 };
+	bool failed_ = false;
+	void work();
+	//Moves the events of all rings to pending_ and returns how many there were
+	size_t drain();
+	void flush();
+public:
+	//Events each Writer can hold before events are dropped, rounded up to a power of two
+	int capacity = 1 << 16;
+	//Events collected before they are written, and the time the background thread waits when the rings are empty
+	int flushEvents = 1 << 15;
+	int intervalMs = 5;
+	SweeperEventLog() {}
+	~SweeperEventLog() { close(); }
+	SweeperEventLog(const SweeperEventLog&) = delete;
+	SweeperEventLog& operator=(const SweeperEventLog&) = delete;
+	//Creates the file, writes its header and starts the background thread
+	bool open(const std::string& path);
+	//Writes the remaining events and closes the file; the Writers must no longer be used. Returns false if a write failed.
+	bool close();
+	bool isOpen() const { return file_ != nullptr; }
+	//A new ring for the calling thread, owned by the log
+	Writer* writer();
+	//Events written to the file so far, resp. dropped because a ring was full
+	uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+	uint64_t dropped();
+	//Reads the events of a log file; returns false if it is not one or was written on a machine of other byte order
+	static bool read(const std::string& path, std::vector<SweeperEvent>* events);
+};
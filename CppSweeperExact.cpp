@@ -0,0 +1,377 @@
+#include "CppSweeper.h"
+#include "CppSweeperTablebase.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+
+//Depth-first enumeration of the mine counts of the groups of a component. need[c] is the number of mines constraint c still
+//requires, open[c] the number of its cells that are not assigned yet. A group of size s holding v mines stands for C(s,v)
+//assignments of its cells, in each of which a cell of the group is a mine with probability v/s.
+struct ComponentEnumerator
+{
+	const ComponentConstraints* constraints;
+	std::vector<int> need;
+	std::vector<int> open;
+	std::vector<int> count;
+	ComponentSolution* solution;
+	long long nodes = 0;
+	long long maxNodes = 0;
+
+	const std::vector<int>& constraintsOf(int group) { return constraints->constraintsOf[constraints->groups[group][0]]; }
+
+	bool assign(int group, int v)
+	{
+		bool consistent = true;
+		int size = (int)constraints->groups[group].size();
+		count[group] = v;
+		for (int c : constraintsOf(group))
+		{
+			need[c] -= v;
+			open[c] -= size;
+			if ((need[c] < 0) || (need[c] > open[c]))
+				consistent = false;
+		}
+		return consistent;
+	}
+
+	void unassign(int group)
+	{
+		int size = (int)constraints->groups[group].size();
+		for (int c : constraintsOf(group))
+		{
+			need[c] += count[group];
+			open[c] += size;
+		}
+	}
+
+	bool search(int group, int mines, double weight)
+	{
+		if (++nodes > maxNodes)
+			return false;
+		if (group == (int)count.size())
+		{
+			solution->weights[mines] += weight;
+			for (unsigned g = 0; g < count.size(); g++)
+				if (count[g] > 0)
+				{
+					double share = weight * count[g] / constraints->groups[g].size();
+					for (int i : constraints->groups[g])
+						solution->cellWeights[i][mines] += share;
+				}
+			return true;
+		}
+		int size = (int)constraints->groups[group].size();
+		for (int v = 0; v <= size; v++)
+		{
+			bool consistent = assign(group, v);
+			bool completed = !consistent || search(group + 1, mines + v, weight * binomialTable.values[size][v]);
+			unassign(group);
+			if (!completed)
+				return false;
+		}
+		return true;
+	}
+};
+
+//Orders the groups of a component so that few constraints are open at a time, i.e. have groups both before and after a
+//position: starting from a group with the fewest constraints, the next group is the one that continues the most open
+//constraints while opening the fewest new ones
+static std::vector<int> groupOrder(const ComponentConstraints& constraints)
+{
+	int n = (int)constraints.groups.size();
+	std::vector<int> order;
+	std::vector<bool> placed(n, false);
+	std::vector<int> touched(constraints.need.size(), 0);
+	while ((int)order.size() < n)
+	{
+		int best = -1;
+		int bestScore = 0;
+		for (int g = 0; g < n; g++)
+		{
+			if (placed[g])
+				continue;
+			int continued = 0, opened = 0;
+			for (int c : constraints.constraintsOf[constraints.groups[g][0]])
+				(touched[c] > 0) ? continued++ : opened++;
+			int score = 2 * continued - opened;
+			if ((best == -1) || (score > bestScore))
+			{
+				best = g;
+				bestScore = score;
+			}
+		}
+		placed[best] = true;
+		order.push_back(best);
+		for (int c : constraints.constraintsOf[constraints.groups[best][0]])
+			touched[c]++;
+	}
+	return order;
+}
+
+//Translates the boundary of a component into constraints over the component's cells and groups the cells by their
+//constraints, listing the groups in the order of groupOrder. Known mines are subtracted from the required counts.
+void CppSweeper_AI::buildComponentConstraints(const ConnectedComponent& component, ComponentConstraints* constraints)
+{
+	int n = (int)component.cellsToSet.size();
+	std::unordered_map<VisibleCell*, int> indexOf;
+	for (int i = 0; i < n; i++)
+		indexOf[component.cellsToSet[i]] = i;
+
+	constraints->need.clear();
+	constraints->cellsOf.clear();
+	constraints->constraintsOf.assign(n, std::vector<int>());
+	for (auto itr = component.boundary.begin(); itr != component.boundary.end(); itr++)
+	{
+		int c = (int)constraints->need.size();
+		int need = (*itr)->neighbouringMines;
+		std::vector<int> cells;
+		for (auto neighbour = (*itr)->neighbouringCells.begin(); neighbour != (*itr)->neighbouringCells.end(); neighbour++)
+		{
+			auto index = indexOf.find(*neighbour);
+			if ((*neighbour)->knownMine)
+				need--;
+			else if (index != indexOf.end())
+			{
+				cells.push_back(index->second);
+				constraints->constraintsOf[index->second].push_back(c);
+			}
+		}
+		constraints->need.push_back(need);
+		constraints->cellsOf.push_back(cells);
+	}
+
+	//The constraint lists are built in ascending order, so equal lists identify interchangeable cells
+	std::map<std::vector<int>, int> groupOf;
+	constraints->groups.clear();
+	constraints->groupsOf.assign(constraints->need.size(), std::vector<int>());
+	for (int i = 0; i < n; i++)
+	{
+		auto itr = groupOf.find(constraints->constraintsOf[i]);
+		if (itr != groupOf.end())
+		{
+			constraints->groups[itr->second].push_back(i);
+			continue;
+		}
+		int g = (int)constraints->groups.size();
+		groupOf[constraints->constraintsOf[i]] = g;
+		constraints->groups.push_back(std::vector<int>(1, i));
+	}
+
+	std::vector<int> order = groupOrder(*constraints);
+	std::vector<std::vector<int>> groups(order.size());
+	for (unsigned p = 0; p < order.size(); p++)
+	{
+		groups[p].swap(constraints->groups[order[p]]);
+		for (int c : constraints->constraintsOf[groups[p][0]])
+			constraints->groupsOf[c].push_back(p);
+	}
+	constraints->groups.swap(groups);
+}
+
+//Enumerates all assignments of the component's cells that are consistent with its boundary, one group of interchangeable
+//cells at a time. Returns false if the enumeration needs more than maxNodes search nodes, in which case solution is incomplete
+bool CppSweeper_AI::enumerateComponent(const ConnectedComponent& component, long long maxNodes, ComponentSolution* solution)
+{
+	int n = (int)component.cellsToSet.size();
+	ComponentConstraints constraints;
+	buildComponentConstraints(component, &constraints);
+
+	ComponentEnumerator enumerator;
+	enumerator.constraints = &constraints;
+	enumerator.need = constraints.need;
+	for (auto itr = constraints.cellsOf.begin(); itr != constraints.cellsOf.end(); itr++)
+		enumerator.open.push_back((int)itr->size());
+
+	solution->cells = component.cellsToSet;
+	solution->weights.assign(n + 1, 0.0);
+	solution->cellWeights.assign(n, std::vector<double>(n + 1, 0.0));
+	enumerator.count.assign(constraints.groups.size(), 0);
+	enumerator.solution = solution;
+	enumerator.maxNodes = maxNodes;
+	bool complete = enumerator.search(0, 0, 1.0);
+	stats_.searchNodes += enumerator.nodes;
+	return complete;
+}
+
+//Solves a component exactly: from the tablebase if it holds the component's pattern, the smallest components by the
+//Gray-code walk, small ones by the bit-sliced enumeration, others (and small ones it cannot finish) with the frontier DP,
+//or by enumeration if the frontier is too wide for the DP
+bool CppSweeper_AI::solveComponent(const ConnectedComponent& component, long long maxNodes, ComponentSolution* solution)
+{
+	int cells = (int)component.cellsToSet.size();
+	if ((tablebase != nullptr) && tablebase->lookup(component, solution))
+	{
+		stats_.cacheHits++;
+		return true;
+	}
+	if ((cells <= grayCodeMaxCells) && grayCodeEnumerate(component, solution))
+		return true;
+	if ((cells <= bitslicedMaxCells) && bitslicedEnumerate(component, maxNodes, solution))
+		return true;
+	return frontierDP(component, solution) || enumerateComponent(component, maxNodes, solution);
+}
+
+static double logBinomial(int n, int k)
+{
+	if ((k < 0) || (k > n))
+		return -INFINITY;
+	return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+static std::vector<double> convolve(const std::vector<double>& a, const std::vector<double>& b)
+{
+	std::vector<double> result(a.size() + b.size() - 1, 0.0);
+	for (unsigned i = 0; i < a.size(); i++)
+		if (a[i] != 0.0)
+			for (unsigned j = 0; j < b.size(); j++)
+				result[i + j] += a[i] * b[j];
+	return result;
+}
+
+//Sets the exact mine probability of every covered cell from the solutions of all components. The components are independent
+//except for the total number of mines: a combination of components with t mines in total is weighted by the number of ways
+//to place the remaining mines on the unconstrained cells, C(unconstrained, remaining - t). Components left out of solutions
+//(and their cells' probabilities) are accounted for only by the number of mines they are expected to hold, outsideMines.
+void CppSweeper_AI::combineSolutions(CppSweeper* game, std::vector<ComponentSolution>* solutions, int outsideMines)
+{
+	int remainingMines = game->mineCount - outsideMines;
+	int unconstrained = 0;
+	for (int x = 0; x < game->width; x++)
+		for (int y = 0; y < game->height; y++)
+		{
+			VisibleCell* cell = game->getCell(x, y);
+			if (cell->knownMine)
+				remainingMines--;
+			else if ((!cell->clicked) && (!cell->isConstrained))
+				unconstrained++;
+		}
+
+	//Scale each component's weights to a maximum of 1; the scale cancels out in the probabilities
+	for (auto solution = solutions->begin(); solution != solutions->end(); solution++)
+	{
+		double scale = *std::max_element(solution->weights.begin(), solution->weights.end());
+		if (scale <= 0.0)
+			continue;
+		for (auto w = solution->weights.begin(); w != solution->weights.end(); w++)
+			*w /= scale;
+		for (auto cell = solution->cellWeights.begin(); cell != solution->cellWeights.end(); cell++)
+			for (auto w = cell->begin(); w != cell->end(); w++)
+				*w /= scale;
+	}
+
+	//prefix[i] is the distribution of the mine count of components 0..i-1, suffix[i] that of components i..end
+	size_t count = solutions->size();
+	std::vector<std::vector<double>> prefix(count + 1, std::vector<double>(1, 1.0));
+	std::vector<std::vector<double>> suffix(count + 1, std::vector<double>(1, 1.0));
+	for (size_t i = 0; i < count; i++)
+		prefix[i + 1] = convolve(prefix[i], (*solutions)[i].weights);
+	for (size_t i = count; i > 0; i--)
+		suffix[i - 1] = convolve(suffix[i], (*solutions)[i - 1].weights);
+
+	int maxMines = (int)prefix[count].size() - 1;
+	std::vector<double> logBlank(maxMines + 1);
+	double logMax = -INFINITY;
+	for (int t = 0; t <= maxMines; t++)
+	{
+		logBlank[t] = logBinomial(unconstrained, remainingMines - t);
+		if (prefix[count][t] > 0.0)
+			logMax = std::max(logMax, logBlank[t]);
+	}
+	std::vector<double> blank(maxMines + 1);
+	for (int t = 0; t <= maxMines; t++)
+		blank[t] = (logMax > -INFINITY) ? std::exp(logBlank[t] - logMax) : 0.0;
+
+	//The expected number of mines outside the components gives the probability of the unconstrained cells
+	double total = 0.0, blankMines = 0.0;
+	for (int t = 0; t <= maxMines; t++)
+	{
+		total += prefix[count][t] * blank[t];
+		blankMines += prefix[count][t] * blank[t] * (remainingMines - t);
+	}
+	double blankProbability = ((unconstrained > 0) && (total > 0.0)) ? blankMines / total / unconstrained : 0.0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		ComponentSolution& solution = (*solutions)[i];
+		std::vector<double> others = convolve(prefix[i], suffix[i + 1]);
+		//weight[k]: the weight of all completions of an assignment of this component with k mines
+		std::vector<double> weight(solution.weights.size(), 0.0);
+		for (unsigned k = 0; k < weight.size(); k++)
+			for (unsigned t = 0; t < others.size(); t++)
+				if (k + t <= (unsigned)maxMines)
+					weight[k] += others[t] * blank[k + t];
+		double norm = 0.0;
+		for (unsigned k = 0; k < weight.size(); k++)
+			norm += solution.weights[k] * weight[k];
+		for (unsigned c = 0; c < solution.cells.size(); c++)
+		{
+			double mines = 0.0;
+			for (unsigned k = 0; k < weight.size(); k++)
+				mines += solution.cellWeights[c][k] * weight[k];
+			solution.cells[c]->mineProbability = (norm > 0.0) ? mines / norm : blankProbability;
+		}
+	}
+
+	for (int x = 0; x < game->width; x++)
+		for (int y = 0; y < game->height; y++)
+		{
+			VisibleCell* cell = game->getCell(x, y);
+			if (cell->knownMine)
+				cell->mineProbability = 1.0;
+			else if ((!cell->clicked) && (!cell->isConstrained))
+				cell->mineProbability = blankProbability;
+		}
+}
+
+//Lowers the probabilities of the unconstrained cells by edgeBias, as the defaults of collectBoundary are for the sampled
+//search, so that the move prefers corner and edge cells among equally likely ones
+void CppSweeper_AI::biasUnconstrainedCells(CppSweeper* game)
+{
+	for (int x = 0; x < game->width; x++)
+		for (int y = 0; y < game->height; y++)
+		{
+			VisibleCell* cell = game->getCell(x, y);
+			if ((!cell->clicked) && (!cell->knownMine) && (!cell->isConstrained))
+				cell->mineProbability -= edgeBias(game, x, y);
+		}
+}
+
+//Computes the exact mine probabilities of all covered cells by solving every connected component exactly.
+//Returns false (leaving the probabilities undefined) if a component cannot be solved within the bounds of the solvers.
+bool CppSweeper_AI::exactProbabilities(CppSweeper* game, long long maxNodes)
+{
+	std::vector<VisibleCell*> boundary;
+	std::vector<VisibleCell*> cellsToSet;
+	collectBoundary(game, &boundary, &cellsToSet);
+	labelConnectedComponents(game, &cellsToSet, &boundary);
+	stats_.components = (int)components.size();
+	stats_.constrainedCells = (int)cellsToSet.size();
+	for (auto itr = components.begin(); itr != components.end(); itr++)
+		stats_.largestComponent = std::max(stats_.largestComponent, (int)itr->cellsToSet.size());
+
+	std::vector<ComponentSolution> solutions(components.size());
+	for (unsigned i = 0; i < components.size(); i++)
+		if (!solveComponent(components[i], maxNodes, &solutions[i]))
+			return false;
+	combineSolutions(game, &solutions, 0);
+	return true;
+}
+
+//Plays the cell of lowest exact mine probability; falls back to the sampled search if a component is too large to be solved
+std::tuple<int, int> CppSweeper_AI::stochasticMove_exact(CppSweeper* game)
+{
+	bool solved;
+	{
+		PhaseTimer timer(stats_.searchTime);
+		solved = exactProbabilities(game, exactMaxNodes);
+	}
+	if (!solved)
+		return stochasticMove_BoundaryBacktracking(game);
+
+	biasUnconstrainedCells(game);
+	std::tuple<int, int> move = getMinimumProbabilityCell(game);
+	if (move != std::tuple<int, int>(-1, -1))
+		lastMove.probability = game->getCell(move)->mineProbability;
+	return move;
+}
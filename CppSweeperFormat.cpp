@@ -0,0 +1,369 @@
+#include "CppSweeperFormat.h"
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint8_t corpusMagic[4] = { 'C', 'S', 'W', 'P' };
+static const int corpusVersion = 1;
+static const size_t headerSize = 8;
+static const size_t recordHeaderSize = 10;
+static const uint8_t nibbleFlagged = 0xE;
+static const uint8_t nibbleCovered = 0xF;
+static const uint32_t moveFlagBit = 0x80000000u;
+
+static uint16_t read16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write16(std::vector<uint8_t>* out, uint16_t value)
+{
+	out->push_back((uint8_t)value);
+	out->push_back((uint8_t)(value >> 8));
+}
+
+static void write32(std::vector<uint8_t>* out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out->push_back((uint8_t)(value >> (8 * i)));
+}
+
+static void writeRecordHeader(std::vector<uint8_t>* out, RecordKind kind, uint8_t flags, int width, int height, int mineCount)
+{
+	out->push_back((uint8_t)kind);
+	out->push_back(flags);
+	write16(out, (uint16_t)width);
+	write16(out, (uint16_t)height);
+	write32(out, (uint32_t)mineCount);
+}
+
+void encodeHeader(std::vector<uint8_t>* out)
+{
+	out->insert(out->end(), corpusMagic, corpusMagic + 4);
+	write16(out, corpusVersion);
+	write16(out, 0);
+}
+
+void encodeRecord(const SweeperPosition& position, std::vector<uint8_t>* out)
+{
+	int cellCount = position.width * position.height;
+	bool hasMines = position.mines.size() > 0;
+	writeRecordHeader(out, RecordKind::RECORD_POSITION, hasMines ? 1 : 0, position.width, position.height, position.mineCount);
+
+	size_t cells = out->size();
+	out->resize(cells + (cellCount + 1) / 2, 0);
+	for (int i = 0; i < cellCount; i++)
+	{
+		signed char value = position.cells[i];
+		uint8_t nibble = (value == SweeperPosition::FLAGGED) ? nibbleFlagged : (value == SweeperPosition::COVERED) ? nibbleCovered : (uint8_t)value;
+		(*out)[cells + i / 2] |= nibble << (4 * (i % 2));
+	}
+	if (hasMines)
+	{
+		size_t mines = out->size();
+		out->resize(mines + (cellCount + 7) / 8, 0);
+		for (int i = 0; i < cellCount; i++)
+			if (position.mines[i])
+				(*out)[mines + i / 8] |= 1 << (i % 8);
+	}
+}
+
+void encodeRecord(const SweeperReplay& replay, std::vector<uint8_t>* out)
+{
+	writeRecordHeader(out, RecordKind::RECORD_REPLAY, replay.zeroNeighbourStart ? 1 : 0, replay.width, replay.height, replay.mineCount);
+	write32(out, replay.seed);
+	write32(out, (uint32_t)replay.moves.size());
+	for (auto itr = replay.moves.begin(); itr != replay.moves.end(); itr++)
+		write32(out, (uint32_t)(itr->x + itr->y * replay.width) | (itr->flag ? moveFlagBit : 0));
+}
+
+signed char SweeperRecord::cell(int index) const
+{
+	uint8_t nibble = (payload[index / 2] >> (4 * (index % 2))) & 0xF;
+	if (nibble == nibbleFlagged)
+		return SweeperPosition::FLAGGED;
+	else if (nibble == nibbleCovered)
+		return SweeperPosition::COVERED;
+	return (signed char)nibble;
+}
+
+bool SweeperRecord::mine(int index) const
+{
+	const uint8_t* mines = payload + (width * height + 1) / 2;
+	return (mines[index / 8] >> (index % 8)) & 1;
+}
+
+ReplayMove SweeperRecord::move(int index) const
+{
+	uint32_t value = read32(payload + 8 + 4 * (size_t)index);
+	int cellIndex = (int)(value & ~moveFlagBit);
+	return ReplayMove{ cellIndex % width, cellIndex / width, (value & moveFlagBit) != 0 };
+}
+
+void SweeperRecord::toPosition(SweeperPosition* position) const
+{
+	int cellCount = width * height;
+	position->width = width;
+	position->height = height;
+	position->mineCount = mineCount;
+	position->cells.resize(cellCount);
+	for (int i = 0; i < cellCount; i++)
+		position->cells[i] = cell(i);
+	position->mines.clear();
+	if (hasMines)
+	{
+		position->mines.resize(cellCount);
+		for (int i = 0; i < cellCount; i++)
+			position->mines[i] = mine(i);
+	}
+}
+
+void SweeperRecord::toReplay(SweeperReplay* replay) const
+{
+	replay->width = width;
+	replay->height = height;
+	replay->mineCount = mineCount;
+	replay->zeroNeighbourStart = zeroNeighbourStart;
+	replay->seed = seed;
+	replay->moves.resize(moveCount);
+	for (int i = 0; i < moveCount; i++)
+		replay->moves[i] = move(i);
+}
+
+bool MappedFile::open(const std::string& path, bool sequential)
+{
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (view == nullptr)
+	{
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_ = file;
+	mapping_ = mapping;
+	size_ = (size_t)size.QuadPart;
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+	struct stat info;
+	if ((fstat(file, &info) != 0) || (info.st_size == 0))
+	{
+		::close(file);
+		return false;
+	}
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (view == MAP_FAILED)
+	{
+		::close(file);
+		return false;
+	}
+	madvise(view, (size_t)info.st_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+	file_ = file;
+	size_ = (size_t)info.st_size;
+#endif
+	data_ = (const uint8_t*)view;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_ == nullptr)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+	CloseHandle((HANDLE)mapping_);
+	CloseHandle((HANDLE)file_);
+	mapping_ = nullptr;
+	file_ = nullptr;
+#else
+	munmap((void*)data_, size_);
+	::close(file_);
+	file_ = -1;
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
+
+bool SweeperCorpus::open(const std::string& path)
+{
+	close();
+	if (!file_.open(path, true))
+		return false;
+	if (!attach(file_.data(), file_.size()))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool SweeperCorpus::attach(const uint8_t* data, size_t size)
+{
+	if ((size < headerSize) || (memcmp(data, corpusMagic, 4) != 0) || (read16(data + 4) != corpusVersion))
+		return false;
+	data_ = data;
+	size_ = size;
+	offset_ = headerSize;
+	corrupt_ = false;
+	return true;
+}
+
+void SweeperCorpus::close()
+{
+	file_.close();
+	data_ = nullptr;
+	size_ = 0;
+	offset_ = 0;
+}
+
+SweeperCorpus::~SweeperCorpus()
+{
+	close();
+}
+
+void SweeperCorpus::rewind()
+{
+	offset_ = headerSize;
+	corrupt_ = false;
+}
+
+size_t decodeRecord(const uint8_t* data, size_t size, SweeperRecord* record)
+{
+	if (size < recordHeaderSize)
+		return 0;
+	uint8_t flags = data[1];
+	record->width = read16(data + 2);
+	record->height = read16(data + 4);
+	record->mineCount = (int)read32(data + 6);
+	record->payload = data + recordHeaderSize;
+	size_t cellCount = (size_t)record->width * record->height;
+	size_t payloadSize;
+	switch (data[0])
+	{
+	case (uint8_t)RecordKind::RECORD_POSITION:
+		record->kind = RecordKind::RECORD_POSITION;
+		record->hasMines = (flags & 1) != 0;
+		record->zeroNeighbourStart = false;
+		record->seed = 0;
+		record->moveCount = 0;
+		payloadSize = (cellCount + 1) / 2 + (record->hasMines ? (cellCount + 7) / 8 : 0);
+		break;
+	case (uint8_t)RecordKind::RECORD_REPLAY:
+		if (size < recordHeaderSize + 8)
+			return 0;
+		record->kind = RecordKind::RECORD_REPLAY;
+		record->hasMines = false;
+		record->zeroNeighbourStart = (flags & 1) != 0;
+		record->seed = read32(record->payload);
+		record->moveCount = (int)read32(record->payload + 4);
+		if ((record->moveCount < 0) || ((size - recordHeaderSize - 8) / 4 < (size_t)record->moveCount))
+			return 0;
+		payloadSize = 8 + 4 * (size_t)record->moveCount;
+		break;
+	default:
+		return 0;
+	}
+	if ((size - recordHeaderSize < payloadSize) || (record->mineCount < 0) || ((size_t)record->mineCount > cellCount))
+		return 0;
+	//Cells must hold a number of neighbouring mines or one of the two special codes, moves must lie on the board
+	if (record->kind == RecordKind::RECORD_POSITION)
+	{
+		for (size_t i = 0; i < cellCount; i++)
+		{
+			uint8_t nibble = (record->payload[i / 2] >> (4 * (i % 2))) & 0xF;
+			if ((nibble > 8) && (nibble != nibbleFlagged) && (nibble != nibbleCovered))
+				return 0;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < record->moveCount; i++)
+			if ((read32(record->payload + 8 + 4 * (size_t)i) & ~moveFlagBit) >= cellCount)
+				return 0;
+	}
+	return recordHeaderSize + payloadSize;
+}
+
+bool SweeperCorpus::next(SweeperRecord* record)
+{
+	if ((data_ == nullptr) || (offset_ == size_) || corrupt_)
+		return false;
+	size_t used = decodeRecord(data_ + offset_, size_ - offset_, record);
+	if (used == 0)
+	{
+		corrupt_ = true;
+		return false;
+	}
+	offset_ += used;
+	return true;
+}
+
+bool SweeperCorpusWriter::open(const std::string& path)
+{
+	close();
+	file_ = fopen(path.c_str(), "wb");
+	if (file_ == nullptr)
+		return false;
+	failed_ = false;
+	encodeHeader(&buffer_);
+	return true;
+}
+
+void SweeperCorpusWriter::flushBuffer()
+{
+	if ((buffer_.size() > 0) && (fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()))
+		failed_ = true;
+	buffer_.clear();
+}
+
+void SweeperCorpusWriter::write(const SweeperPosition& position)
+{
+	encodeRecord(position, &buffer_);
+	if (buffer_.size() >= (1 << 16))
+		flushBuffer();
+}
+
+void SweeperCorpusWriter::write(const SweeperReplay& replay)
+{
+	encodeRecord(replay, &buffer_);
+	if (buffer_.size() >= (1 << 16))
+		flushBuffer();
+}
+
+bool SweeperCorpusWriter::close()
+{
+	if (file_ == nullptr)
+		return !failed_;
+	flushBuffer();
+	if (fclose(file_) != 0)
+		failed_ = true;
+	file_ = nullptr;
+	return !failed_;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "CppSweeper.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// O------------------------------------------------------------------------------O
+// | Binary corpus format for positions and replays (all integers little endian): |
+// |   file header:  "CSWP", uint16 version, uint16 reserved					  |
+// |   record:       uint8 kind, uint8 flags, uint16 width, uint16 height,		  |
+// |                 uint32 mineCount, followed by the payload of the kind		  |
+// |   position:     cells packed two per byte (low nibble first; 0-8 revealed,	  |
+// |                 0xE flagged, 0xF covered), then the mine layout as one bit	  |
+// |                 per cell if flags bit 0 is set								  |
+// |   replay:       uint32 seed, uint32 moveCount, one uint32 per move holding	  |
+// |                 the cell index, with bit 31 set for flag toggles; flags	  |
+// |                 bit 0 marks a zero-neighbour first click					  |
+// | Cells are indexed x + y * width, as in SweeperPosition.					  |
+// O------------------------------------------------------------------------------O
+enum class RecordKind { RECORD_POSITION = 1, RECORD_REPLAY = 2 };
+
+// O------------------------------------------------------------------------------O
+// | A record of a corpus, pointing into the mapped file. Valid as long as the	  |
+// | SweeperCorpus it was read from stays open.									  |
+// O------------------------------------------------------------------------------O
+struct SweeperRecord
+{
+	RecordKind kind;
+	int width;
+	int height;
+	int mineCount;
+	bool hasMines;
+	bool zeroNeighbourStart;
+	unsigned int seed;
+	int moveCount;
+	const uint8_t* payload;
+
+	signed char cell(int index) const;
+	bool mine(int index) const;
+	ReplayMove move(int index) const;
+	void toPosition(SweeperPosition* position) const;
+	void toReplay(SweeperReplay* replay) const;
+};
+
+// O------------------------------------------------------------------------------O
+// | A read-only memory mapping of a whole file. Mappings of the same file by	  |
+// | several processes share the pages of the OS page cache.					  |
+// O------------------------------------------------------------------------------O
+class MappedFile
+{
+private:
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+#else
+	int file_ = -1;
+#endif
+public:
+	//Maps the file at path; returns false if it cannot be opened or is empty. sequential hints that it is read front to back.
+	bool open(const std::string& path, bool sequential);
+	void close();
+	const uint8_t* data() const { return data_; }
+	size_t size() const { return size_; }
+	bool isOpen() const { return data_ != nullptr; }
+	MappedFile() {}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { close(); }
+};
+
+// O------------------------------------------------------------------------------O
+// | Read access to a corpus file. The file is memory mapped and its records are  |
+// | iterated in place with next; nothing is copied unless a record is converted. |
+// O------------------------------------------------------------------------------O
+class SweeperCorpus
+{
+private:
+	MappedFile file_;
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+	size_t offset_ = 0;
+	bool corrupt_ = false;
+public:
+	//Maps the file at path; returns false if it cannot be opened or does not start with the corpus header
+	bool open(const std::string& path);
+	//Reads from a corpus already in memory (e.g. read from a pipe); the buffer must outlive the corpus
+	bool attach(const uint8_t* data, size_t size);
+	void close();
+	//Advances to the next record; returns false at the end of the corpus or at a truncated record
+	bool next(SweeperRecord* record);
+	void rewind();
+	bool corrupt() { return corrupt_; }
+	SweeperCorpus() {}
+	SweeperCorpus(const SweeperCorpus&) = delete;
+	SweeperCorpus& operator=(const SweeperCorpus&) = delete;
+	~SweeperCorpus();
+};
+
+// O------------------------------------------------------------------------------O
+// | Writes a corpus file. Records are appended in the order of the write calls.  |
+// O------------------------------------------------------------------------------O
+class SweeperCorpusWriter
+{
+private:
+	FILE* file_ = nullptr;
+	std::vector<uint8_t> buffer_;
+	bool failed_ = false;
+	void flushBuffer();
+public:
+	bool open(const std::string& path);
+	void write(const SweeperPosition& position);
+	void write(const SweeperReplay& replay);
+	//Returns false if any write to the file failed
+	bool close();
+	SweeperCorpusWriter() {}
+	SweeperCorpusWriter(const SweeperCorpusWriter&) = delete;
+	SweeperCorpusWriter& operator=(const SweeperCorpusWriter&) = delete;
+	~SweeperCorpusWriter() { close(); }
+};
+
+//Encodes a single record (without the file header), e.g. to send a position over a pipe
+void encodeRecord(const SweeperPosition& position, std::vector<uint8_t>* out);
+void encodeRecord(const SweeperReplay& replay, std::vector<uint8_t>* out);
+//Decodes a single record as written by encodeRecord; returns its size in bytes, or 0 if data does not hold a complete and valid
+//record (cell codes, mine count and replay moves within the board). record points into data.
+size_t decodeRecord(const uint8_t* data, size_t size, SweeperRecord* record);
+//Appends the file header
+void encodeHeader(std::vector<uint8_t>* out);
@@ -0,0 +1,192 @@
+#include "CppSweeper.h"
+#include <algorithm>
+#include <unordered_map>
+
+//A layer of the frontier DP: the distinct states after the first p groups of the component, each with a polynomial in the number
+//of mines (stored flat with stride cells+1). A state packs the partial sums of the open constraints, 4 bits per slot.
+struct FrontierLayer
+{
+	std::vector<uint64_t> keys;
+	std::unordered_map<uint64_t, int> indexOf;
+	std::vector<double> values;
+	int stride = 1;
+
+	double* add(uint64_t key)
+	{
+		auto itr = indexOf.find(key);
+		if (itr != indexOf.end())
+			return &values[(size_t)itr->second * stride];
+		indexOf[key] = (int)keys.size();
+		keys.push_back(key);
+		values.resize(values.size() + stride, 0.0);
+		return &values[values.size() - stride];
+	}
+};
+
+//The effect of a group on one of its constraints: the slot of the constraint, the cells of it in the groups that follow and
+//whether the group is its last one
+struct FrontierUpdate
+{
+	int slot;
+	int need;
+	int remaining;
+	bool last;
+};
+
+//Returns the state after placing value mines in a group, or false if that violates one of the group's constraints
+static bool frontierTransition(uint64_t key, const std::vector<FrontierUpdate>& updates, int value, uint64_t* next)
+{
+	for (auto itr = updates.begin(); itr != updates.end(); itr++)
+	{
+		int shift = 4 * itr->slot;
+		int sum = (int)((key >> shift) & 0xF) + value;
+		if ((sum > itr->need) || (sum + itr->remaining < itr->need))
+			return false;
+		key &= ~((uint64_t)0xF << shift);
+		if (!itr->last)
+			key |= (uint64_t)sum << shift;
+	}
+	*next = key;
+	return true;
+}
+
+//Solves a component exactly by dynamic programming along its groups of interchangeable cells. The state after a prefix of the
+//groups consists of the partial sums of the constraints that have groups on both sides of it, so the cost
+//grows exponentially with the number of such open constraints instead of the number of cells. Returns false if more than 16
+//constraints would be open at once or a layer exceeds frontierMaxStates.
+bool CppSweeper_AI::frontierDP(const ConnectedComponent& component, ComponentSolution* solution)
+{
+	int n = (int)component.cellsToSet.size();
+	ComponentConstraints constraints;
+	buildComponentConstraints(component, &constraints);
+	solution->cells = component.cellsToSet;
+	solution->weights.assign(n + 1, 0.0);
+	solution->cellWeights.assign(n, std::vector<double>(n + 1, 0.0));
+	for (unsigned c = 0; c < constraints.need.size(); c++)
+		if ((constraints.cellsOf[c].size() == 0) && (constraints.need[c] != 0))
+			return true;
+
+	//The groups are processed in their order, which keeps few constraints open (cf. buildComponentConstraints)
+	int groupCount = (int)constraints.groups.size();
+	//cellsBefore[p]: the number of cells in the first p groups
+	std::vector<int> cellsBefore(groupCount + 1, 0);
+	for (int p = 0; p < groupCount; p++)
+		cellsBefore[p + 1] = cellsBefore[p] + (int)constraints.groups[p].size();
+
+	//Give each constraint a slot from its first to its last group
+	int m = (int)constraints.need.size();
+	std::vector<int> first(m, groupCount), last(m, -1), slot(m, -1);
+	for (int c = 0; c < m; c++)
+		for (int g : constraints.groupsOf[c])
+		{
+			first[c] = std::min(first[c], g);
+			last[c] = std::max(last[c], g);
+		}
+	std::vector<std::vector<FrontierUpdate>> updates(groupCount);
+	std::vector<int> freeSlots;
+	for (int s = 15; s >= 0; s--)
+		freeSlots.push_back(s);
+	for (int p = 0; p < groupCount; p++)
+	{
+		const std::vector<int>& groupConstraints = constraints.constraintsOf[constraints.groups[p][0]];
+		for (int c : groupConstraints)
+			if (first[c] == p)
+			{
+				if (freeSlots.size() == 0)
+					return false;
+				slot[c] = freeSlots.back();
+				freeSlots.pop_back();
+			}
+		for (int c : groupConstraints)
+		{
+			int remaining = 0;
+			for (int g : constraints.groupsOf[c])
+				if (g > p)
+					remaining += (int)constraints.groups[g].size();
+			updates[p].push_back(FrontierUpdate{ slot[c], constraints.need[c], remaining, last[c] == p });
+		}
+		for (int c : groupConstraints)
+			if (last[c] == p)
+				freeSlots.push_back(slot[c]);
+	}
+
+	//Forward pass: forward[p] holds the number of consistent assignments of the first p groups per state and mine count
+	std::vector<FrontierLayer> forward(groupCount + 1);
+	*forward[0].add(0) = 1.0;
+	for (int p = 0; p < groupCount; p++)
+	{
+		FrontierLayer& layer = forward[p];
+		FrontierLayer& next = forward[p + 1];
+		int size = (int)constraints.groups[p].size();
+		next.stride = cellsBefore[p + 1] + 1;
+		for (unsigned s = 0; s < layer.keys.size(); s++)
+		{
+			const double* poly = &layer.values[(size_t)s * layer.stride];
+			for (int value = 0; value <= size; value++)
+			{
+				uint64_t key;
+				if (!frontierTransition(layer.keys[s], updates[p], value, &key))
+					continue;
+				double ways = (double)binomialTable.values[size][value];
+				double* target = next.add(key);
+				for (int k = 0; k < layer.stride; k++)
+					target[k + value] += ways * poly[k];
+			}
+		}
+		stats_.searchNodes += layer.keys.size();
+		if ((int)next.keys.size() > frontierMaxStates)
+			return false;
+	}
+	if (forward[groupCount].keys.size() == 0)
+		return true;
+	for (int k = 0; k <= n; k++)
+		solution->weights[k] = forward[groupCount].values[k];
+
+	//Backward pass: backward holds the number of consistent completions of the groups from p on, per state of forward[p];
+	//combining both passes at a group holding value mines yields the weights of its cells, each a mine with value/size
+	std::vector<double> backward(1, 1.0);
+	int backwardStride = 1;
+	for (int p = groupCount - 1; p >= 0; p--)
+	{
+		FrontierLayer& layer = forward[p];
+		FrontierLayer& next = forward[p + 1];
+		const std::vector<int>& group = constraints.groups[p];
+		int size = (int)group.size();
+		int stride = n - cellsBefore[p] + 1;
+		std::vector<double> current(layer.keys.size() * stride, 0.0);
+		std::vector<double> groupWeights(n + 1, 0.0);
+		for (unsigned s = 0; s < layer.keys.size(); s++)
+		{
+			double* target = &current[(size_t)s * stride];
+			for (int value = 0; value <= size; value++)
+			{
+				uint64_t key;
+				if (!frontierTransition(layer.keys[s], updates[p], value, &key))
+					continue;
+				auto itr = next.indexOf.find(key);
+				if (itr == next.indexOf.end())
+					continue;
+				double ways = (double)binomialTable.values[size][value];
+				const double* completions = &backward[(size_t)itr->second * backwardStride];
+				for (int k = 0; k < backwardStride; k++)
+					target[k + value] += ways * completions[k];
+				if (value > 0)
+				{
+					double share = ways * value / size;
+					const double* prefix = &layer.values[(size_t)s * layer.stride];
+					for (int a = 0; a < layer.stride; a++)
+						if (prefix[a] != 0.0)
+							for (int k = 0; k < backwardStride; k++)
+								groupWeights[a + k + value] += share * prefix[a] * completions[k];
+				}
+			}
+		}
+		for (int i : group)
+			solution->cellWeights[i] = groupWeights;
+		backward.swap(current);
+		backwardStride = stride;
+		//The layers behind p are no longer needed
+		next = FrontierLayer();
+	}
+	return true;
+}
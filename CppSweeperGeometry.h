@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// O------------------------------------------------------------------------------O
+// | Writes the indices (x+y*width) of the neighbours of cell index to out, in	  |
+// | the order used throughout the engine, and returns their number.			  |
+// O------------------------------------------------------------------------------O
+constexpr int listNeighbours(int width, int height, int index, int32_t* out)
+{
+	int x = index % width;
+	int y = index / width;
+	int n = 0;
+	if (x > 0)
+	{
+		out[n++] = index - 1;
+		if (y > 0)
+			out[n++] = index - 1 - width;
+		if (y < height - 1)
+			out[n++] = index - 1 + width;
+	}
+	if (x < width - 1)
+	{
+		out[n++] = index + 1;
+		if (y > 0)
+			out[n++] = index + 1 - width;
+		if (y < height - 1)
+			out[n++] = index + 1 + width;
+	}
+	if (y < height - 1)
+		out[n++] = index + width;
+	if (y > 0)
+		out[n++] = index - width;
+	return n;
+}
+
+// O------------------------------------------------------------------------------O
+// | Neighbour table of a board size known at compile time: 8 slots per cell,	  |
+// | of which the first neighbourCount[i] are used.								  |
+// O------------------------------------------------------------------------------O
+template <int W, int H>
+struct FixedGeometry
+{
+	std::array<int32_t, 8 * W * H> neighbours{};
+	std::array<uint8_t, W * H> neighbourCount{};
+
+	constexpr FixedGeometry()
+	{
+		for (int i = 0; i < W * H; i++)
+			neighbourCount[i] = (uint8_t)listNeighbours(W, H, i, neighbours.data() + 8 * i);
+	}
+};
+
+template <int W, int H>
+constexpr FixedGeometry<W, H> fixedGeometry = FixedGeometry<W, H>();
+
+// O------------------------------------------------------------------------------O
+// | Neighbour table of the board of a game. The standard sizes (9x9, 16x16 and	  |
+// | 30x16) use the tables built at compile time; other sizes are built when the  |
+// | size is set.																  |
+// O------------------------------------------------------------------------------O
+class BoardGeometry
+{
+private:
+	std::vector<int32_t> neighbourStorage;
+	std::vector<uint8_t> countStorage;
+
+	template <int W, int H>
+	void useFixed()
+	{
+		neighbours = fixedGeometry<W, H>.neighbours.data();
+		neighbourCount = fixedGeometry<W, H>.neighbourCount.data();
+	}
+public:
+	int width = 0;
+	int height = 0;
+	const int32_t* neighbours = nullptr;
+	const uint8_t* neighbourCount = nullptr;
+
+	void setSize(int width, int height)
+	{
+		if ((neighbours != nullptr) && (width == this->width) && (height == this->height))
+			return;
+		this->width = width;
+		this->height = height;
+		if ((width == 9) && (height == 9))
+			useFixed<9, 9>();
+		else if ((width == 16) && (height == 16))
+			useFixed<16, 16>();
+		else if ((width == 30) && (height == 16))
+			useFixed<30, 16>();
+		else
+		{
+			neighbourStorage.assign(8 * (size_t)width * height, 0);
+			countStorage.assign((size_t)width * height, 0);
+			for (int i = 0; i < width * height; i++)
+				countStorage[i] = (uint8_t)listNeighbours(width, height, i, neighbourStorage.data() + 8 * (size_t)i);
+			neighbours = neighbourStorage.data();
+			neighbourCount = countStorage.data();
+		}
+	}
+};
+
+// O------------------------------------------------------------------------------O
+// | Binomial coefficients C(n,k) for n up to MAX_N, built at compile time		  |
+// O------------------------------------------------------------------------------O
+struct BinomialTable
+{
+	static const int MAX_N = 64;
+	long long values[MAX_N + 1][MAX_N + 1] = {};
+
+	constexpr BinomialTable()
+	{
+		for (int n = 0; n <= MAX_N; n++)
+		{
+			values[n][0] = 1;
+			for (int k = 1; k <= n; k++)
+				values[n][k] = values[n - 1][k - 1] + ((k < n) ? values[n - 1][k] : 0);
+		}
+	}
+};
+
+constexpr BinomialTable binomialTable = BinomialTable();
@@ -0,0 +1,53 @@
+#include "CppSweeper.h"
+#include "CppSweeperBits.h"
+
+//Solves a small component by walking through all assignments of its cells in Gray-code order. Each step flips a single
+//cell, so only the sums of the (at most 8) constraints of that cell change, and the number of violated constraints tells
+//whether the new assignment is consistent; there is no recursion and no rescan of the boundary. The cost is 2^cells steps
+//regardless of the constraints, so this only suits components of up to grayCodeMaxCells cells. Returns false for
+//components of more than 62 cells.
+bool CppSweeper_AI::grayCodeEnumerate(const ConnectedComponent& component, ComponentSolution* solution)
+{
+	int n = (int)component.cellsToSet.size();
+	if (n > 62)
+		return false;
+	ComponentConstraints constraints;
+	buildComponentConstraints(component, &constraints);
+	solution->cells = component.cellsToSet;
+	solution->weights.assign(n + 1, 0.0);
+	solution->cellWeights.assign(n, std::vector<double>(n + 1, 0.0));
+
+	std::vector<int> sum(constraints.need.size(), 0);
+	int violated = 0;
+	for (unsigned c = 0; c < constraints.need.size(); c++)
+		violated += (constraints.need[c] != 0);
+
+	//Bit i of assignment is the value of cell i
+	uint64_t assignment = 0;
+	int mines = 0;
+	uint64_t steps = (uint64_t)1 << n;
+	for (uint64_t step = 0; step < steps; step++)
+	{
+		if (step > 0)
+		{
+			//Gray code: step s flips the cell of the lowest set bit of s
+			int cell = trailingZeros64(step);
+			int delta = ((assignment >> cell) & 1) ? -1 : 1;
+			assignment ^= (uint64_t)1 << cell;
+			mines += delta;
+			for (int c : constraints.constraintsOf[cell])
+			{
+				violated += (sum[c] == constraints.need[c]);
+				sum[c] += delta;
+				violated -= (sum[c] == constraints.need[c]);
+			}
+		}
+		if (violated != 0)
+			continue;
+		solution->weights[mines] += 1.0;
+		for (uint64_t cells = assignment; cells != 0; cells &= cells - 1)
+			solution->cellWeights[trailingZeros64(cells)][mines] += 1.0;
+	}
+	stats_.leaves += (long long)steps;
+	return true;
+}
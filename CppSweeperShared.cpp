@@ -0,0 +1,278 @@
+#include "CppSweeperShared.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char mapMagic[4] = { 'C', 'S', 'S', 'M' };
+static const uint32_t mapVersion = 1;
+
+struct SharedMapHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t reserved;
+	std::atomic<uint64_t> sequence;
+	SharedMapCounters counters;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the sequence must be lock free to be shared between processes");
+
+static size_t headerSize()
+{
+	return (sizeof(SharedMapHeader) + 7) & ~(size_t)7;
+}
+
+static size_t segmentSize(uint32_t capacity)
+{
+	return headerSize() + (size_t)capacity * (sizeof(float) + sizeof(int32_t) + sizeof(int8_t));
+}
+
+bool SharedSegment::create(const std::string& name, size_t size)
+{
+	close();
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, name.c_str());
+	void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+	if (view == nullptr)
+	{
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		return false;
+	}
+	mapping_ = mapping;
+#else
+	std::string path = "/" + name;
+	shm_unlink(path.c_str());
+	int file = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (file < 0)
+		return false;
+	void* view = (ftruncate(file, (off_t)size) == 0) ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+	::close(file);
+	if (view == MAP_FAILED)
+	{
+		shm_unlink(path.c_str());
+		return false;
+	}
+#endif
+	data_ = (uint8_t*)view;
+	size_ = size;
+	name_ = name;
+	owner_ = true;
+	return true;
+}
+
+bool SharedSegment::attach(const std::string& name)
+{
+	close();
+#ifdef _WIN32
+	HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+	void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	MEMORY_BASIC_INFORMATION info;
+	if ((view == nullptr) || (VirtualQuery(view, &info, sizeof(info)) == 0))
+	{
+		if (view != nullptr)
+			UnmapViewOfFile(view);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		return false;
+	}
+	mapping_ = mapping;
+	size_ = (size_t)info.RegionSize;
+#else
+	std::string path = "/" + name;
+	int file = shm_open(path.c_str(), O_RDONLY, 0);
+	if (file < 0)
+		return false;
+	struct stat info;
+	void* view = MAP_FAILED;
+	if ((fstat(file, &info) == 0) && (info.st_size > 0))
+		view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+	::close(file);
+	if (view == MAP_FAILED)
+		return false;
+	size_ = (size_t)info.st_size;
+#endif
+	data_ = (uint8_t*)view;
+	name_ = name;
+	owner_ = false;
+	return true;
+}
+
+void SharedSegment::close()
+{
+	if (data_ == nullptr)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+	CloseHandle((HANDLE)mapping_);
+	mapping_ = nullptr;
+#else
+	munmap(data_, size_);
+	if (owner_)
+		shm_unlink(("/" + name_).c_str());
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	owner_ = false;
+}
+
+bool SweeperMapPublisher::open(const std::string& name, int capacity)
+{
+	close();
+	if ((capacity <= 0) || !segment_.create(name, segmentSize((uint32_t)capacity)))
+		return false;
+	capacity_ = (uint32_t)capacity;
+	SharedMapHeader* header = new (segment_.data()) SharedMapHeader();
+	header->sequence.store(1, std::memory_order_relaxed);
+	std::memcpy(header->magic, mapMagic, 4);
+	header->version = mapVersion;
+	header->capacity = capacity_;
+	header->reserved = 0;
+	header->counters = SharedMapCounters();
+	header->sequence.store(2, std::memory_order_release);
+	return true;
+}
+
+void SweeperMapPublisher::close()
+{
+	segment_.close();
+	capacity_ = 0;
+}
+
+bool SweeperMapPublisher::publish(CppSweeper* game, CppSweeper_AI& engine)
+{
+	if ((!isOpen()) || ((uint32_t)(game->width * game->height) > capacity_))
+		return false;
+	SharedMapHeader* header = (SharedMapHeader*)segment_.data();
+	float* probabilities = (float*)(segment_.data() + headerSize());
+	int32_t* labels = (int32_t*)(probabilities + capacity_);
+	int8_t* cells = (int8_t*)(labels + capacity_);
+
+	uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+	header->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	int knownMines = 0;
+	for (int y = 0; y < game->height; y++)
+		for (int x = 0; x < game->width; x++)
+		{
+			VisibleCell* cell = game->getCell(x, y);
+			int i = x + y * game->width;
+			probabilities[i] = (float)cell->mineProbability;
+			labels[i] = cell->connectedComponent;
+			if (cell->clicked)
+				cells[i] = (int8_t)cell->neighbouringMines;
+			else if (cell->knownMine)
+			{
+				cells[i] = SharedMapSnapshot::KNOWN_MINE;
+				knownMines++;
+			}
+			else if (cell->flag)
+				cells[i] = SweeperPosition::FLAGGED;
+			else
+				cells[i] = SweeperPosition::COVERED;
+		}
+
+	const AI_Stats& stats = engine.lastStats();
+	SharedMapCounters& counters = header->counters;
+	counters.width = game->width;
+	counters.height = game->height;
+	counters.mineCount = game->mineCount;
+	counters.knownMines = knownMines;
+	counters.moveNo = engine.lastMove.moveNo;
+	counters.moveType = (int32_t)engine.lastMove.moveType;
+	counters.moveX = engine.lastMove.x;
+	counters.moveY = engine.lastMove.y;
+	counters.moveProbability = engine.lastMove.probability;
+	counters.moves = engine.moves;
+	counters.guesses = engine.guesses;
+	counters.samples = engine.samples();
+	counters.validSamples = engine.validSamples();
+	counters.components = engine.connectedComponents();
+	counters.largestComponent = stats.largestComponent;
+	counters.wins = game->wins();
+	counters.losses = game->losses();
+	counters.moveTime = stats.totalTime;
+	counters.searchNodes = stats.searchNodes;
+
+	header->sequence.store(sequence + 2, std::memory_order_release);
+	return true;
+}
+
+bool SweeperMapReader::open(const std::string& name)
+{
+	close();
+	if (!segment_.attach(name))
+		return false;
+	const SharedMapHeader* header = (const SharedMapHeader*)segment_.data();
+	if ((segment_.size() < headerSize()) || (std::memcmp(header->magic, mapMagic, 4) != 0) || (header->version != mapVersion) ||
+		(segment_.size() < segmentSize(header->capacity)))
+	{
+		close();
+		return false;
+	}
+	capacity_ = header->capacity;
+	return true;
+}
+
+void SweeperMapReader::close()
+{
+	segment_.close();
+	capacity_ = 0;
+}
+
+uint64_t SweeperMapReader::sequence() const
+{
+	if (segment_.data() == nullptr)
+		return 0;
+	return ((const SharedMapHeader*)segment_.data())->sequence.load(std::memory_order_acquire);
+}
+
+bool SweeperMapReader::read(SharedMapSnapshot* snapshot, int attempts) const
+{
+	if (segment_.data() == nullptr)
+		return false;
+	const SharedMapHeader* header = (const SharedMapHeader*)segment_.data();
+	const float* probabilities = (const float*)(segment_.data() + headerSize());
+	const int32_t* labels = (const int32_t*)(probabilities + capacity_);
+	const int8_t* cells = (const int8_t*)(labels + capacity_);
+	for (int attempt = 0; attempt < attempts; attempt++)
+	{
+		uint64_t before = header->sequence.load(std::memory_order_acquire);
+		if (before & 1)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		std::memcpy(&snapshot->counters, &header->counters, sizeof(SharedMapCounters));
+		//A torn read of the size is caught by the sequence check below, but must not overrun the arrays
+		size_t count = (size_t)std::max(0, snapshot->counters.width) * (size_t)std::max(0, snapshot->counters.height);
+		if (count > capacity_)
+			count = 0;
+		snapshot->probabilities.resize(count);
+		snapshot->labels.resize(count);
+		snapshot->cells.resize(count);
+		std::memcpy(snapshot->probabilities.data(), probabilities, count * sizeof(float));
+		std::memcpy(snapshot->labels.data(), labels, count * sizeof(int32_t));
+		std::memcpy(snapshot->cells.data(), cells, count * sizeof(int8_t));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (header->sequence.load(std::memory_order_relaxed) == before)
+		{
+			snapshot->sequence = before;
+			return true;
+		}
+	}
+	return false;
+}
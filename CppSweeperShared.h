@@ -0,0 +1,120 @@
+#pragma once
+#include "CppSweeper.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// O------------------------------------------------------------------------------O
+// | Shared memory segment with the engine state of the last move, for viewers	  |
+// | in other processes (native byte order, as it never leaves the machine):	  |
+// |   header:  "CSSM", uint32 version, uint32 capacity (cells), uint32			  |
+// |            reserved, uint64 sequence, SharedMapCounters					  |
+// |   arrays:  float probabilities[capacity], int32 labels[capacity] (the		  |
+// |            connected component, -1 for none), int8 cells[capacity]		  |
+// |            (revealed number, or COVERED/FLAGGED as in SweeperPosition,	  |
+// |            KNOWN_MINE), each indexed by x+y*width							  |
+// | The sequence is a seqlock: the writer makes it odd, writes the counters	  |
+// | and the arrays and makes it even again. A reader copies what it needs and  |
+// | keeps the copy only if the sequence was even and unchanged meanwhile, so	  |
+// | readers never block the writer and take no lock.							  |
+// O------------------------------------------------------------------------------O
+struct SharedMapCounters
+{
+	int32_t width;
+	int32_t height;
+	int32_t mineCount;
+	int32_t knownMines;
+	int32_t moveNo;
+	int32_t moveType;
+	int32_t moveX;
+	int32_t moveY;
+	double moveProbability;
+	int64_t moves;
+	int64_t guesses;
+	int64_t samples;
+	int64_t validSamples;
+	int32_t components;
+	int32_t largestComponent;
+	int32_t wins;
+	int32_t losses;
+	//Of the last move, in microseconds
+	double moveTime;
+	int64_t searchNodes;
+};
+
+struct SharedMapSnapshot
+{
+	enum : int8_t { KNOWN_MINE = -3 };
+	uint64_t sequence = 0;
+	SharedMapCounters counters = SharedMapCounters();
+	std::vector<float> probabilities;
+	std::vector<int32_t> labels;
+	std::vector<int8_t> cells;
+};
+
+// O------------------------------------------------------------------------------O
+// | A mapped shared memory segment (POSIX shm_open, named file mapping on		  |
+// | Windows). The name is given without a leading slash.						  |
+// O------------------------------------------------------------------------------O
+class SharedSegment
+{
+private:
+	uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+	std::string name_;
+	bool owner_ = false;
+#ifdef _WIN32
+	void* mapping_ = nullptr;
+#endif
+public:
+	//Creates (or replaces) the segment with the given size, writable
+	bool create(const std::string& name, size_t size);
+	//Maps an existing segment read-only
+	bool attach(const std::string& name);
+	//Unmaps the segment; a segment created here is removed, readers keep their mapping
+	void close();
+	uint8_t* data() const { return data_; }
+	size_t size() const { return size_; }
+	SharedSegment() {}
+	SharedSegment(const SharedSegment&) = delete;
+	SharedSegment& operator=(const SharedSegment&) = delete;
+	~SharedSegment() { close(); }
+};
+
+// O------------------------------------------------------------------------------O
+// | Writes the engine state into a shared segment. There must be one writer,	  |
+// | which is the engine that has this as its publisher (or the thread that		  |
+// | drives it).																  |
+// O------------------------------------------------------------------------------O
+class SweeperMapPublisher
+{
+private:
+	SharedSegment segment_;
+	uint32_t capacity_ = 0;
+public:
+	//Creates the segment with room for boards of up to capacity cells
+	bool open(const std::string& name, int capacity);
+	void close();
+	bool isOpen() const { return segment_.data() != nullptr; }
+	//Publishes the cells of game and the counters of engine; returns false if the board does not fit
+	bool publish(CppSweeper* game, CppSweeper_AI& engine);
+};
+
+// O------------------------------------------------------------------------------O
+// | Reads the segment of a publisher, which may be in another process.			  |
+// O------------------------------------------------------------------------------O
+class SweeperMapReader
+{
+private:
+	SharedSegment segment_;
+	uint32_t capacity_ = 0;
+public:
+	//Maps the segment; returns false if it does not exist or is not a map segment
+	bool open(const std::string& name);
+	void close();
+	//The current sequence, to see whether anything has been published since a snapshot; odd while the writer is busy
+	uint64_t sequence() const;
+	//Copies a consistent state into snapshot, retrying up to attempts times while the writer is busy; false if none was read
+	bool read(SharedMapSnapshot* snapshot, int attempts = 1000) const;
+};
@@ -0,0 +1,308 @@
+#include "CppSweeperSpeculation.h"
+#include "CppSweeperTrace.h"
+#include <algorithm>
+
+SweeperSpeculation::SweeperSpeculation()
+{
+	game_.AI = &engine_;
+	thread_ = std::thread(&SweeperSpeculation::work, this);
+}
+
+SweeperSpeculation::~SweeperSpeculation()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+		jobs_.clear();
+		stale_ = true;
+		engine_.interrupt = true;
+	}
+	wake_.notify_all();
+	thread_.join();
+}
+
+bool SweeperSpeculation::Settings::operator==(const Settings& other) const
+{
+	return (stochasticMethod == other.stochasticMethod) && (maxSamples == other.maxSamples) &&
+		(searchNodesPerSample == other.searchNodesPerSample) && (rotate == other.rotate) && (maxProbes == other.maxProbes) &&
+		(gaussianMaxCells == other.gaussianMaxCells) && (frontierMaxStates == other.frontierMaxStates) &&
+		(exactMaxNodes == other.exactMaxNodes) && (grayCodeMaxCells == other.grayCodeMaxCells) &&
+		(bitslicedMaxCells == other.bitslicedMaxCells) && (exactFastPathCells == other.exactFastPathCells) &&
+		(cascadeMaxNodes == other.cascadeMaxNodes) && (cascadeConfidence == other.cascadeConfidence) &&
+		(beliefMaxIterations == other.beliefMaxIterations) && (beliefDamping == other.beliefDamping) &&
+		(beliefTolerance == other.beliefTolerance) && (tablebase == other.tablebase);
+}
+
+SweeperSpeculation::Settings SweeperSpeculation::Settings::of(const CppSweeper_AI& engine)
+{
+	return Settings{ engine.stochasticMethod, engine.maxSamples, engine.searchNodesPerSample, engine.rotate, engine.maxProbes,
+		engine.gaussianMaxCells, engine.frontierMaxStates, engine.exactMaxNodes, engine.grayCodeMaxCells, engine.bitslicedMaxCells,
+		engine.exactFastPathCells, engine.cascadeMaxNodes, engine.cascadeConfidence, engine.beliefMaxIterations, engine.beliefDamping,
+		engine.beliefTolerance, engine.tablebase };
+}
+
+void SweeperSpeculation::Settings::apply(CppSweeper_AI& engine) const
+{
+	engine.stochasticMethod = stochasticMethod;
+	engine.maxSamples = maxSamples;
+	engine.searchNodesPerSample = searchNodesPerSample;
+	engine.rotate = rotate;
+	engine.maxProbes = maxProbes;
+	engine.gaussianMaxCells = gaussianMaxCells;
+	engine.frontierMaxStates = frontierMaxStates;
+	engine.exactMaxNodes = exactMaxNodes;
+	engine.grayCodeMaxCells = grayCodeMaxCells;
+	engine.bitslicedMaxCells = bitslicedMaxCells;
+	engine.exactFastPathCells = exactFastPathCells;
+	engine.cascadeMaxNodes = cascadeMaxNodes;
+	engine.cascadeConfidence = cascadeConfidence;
+	engine.beliefMaxIterations = beliefMaxIterations;
+	engine.beliefDamping = beliefDamping;
+	engine.beliefTolerance = beliefTolerance;
+	engine.tablebase = tablebase;
+}
+
+void SweeperSpeculation::start(const SweeperPosition& position, const CppSweeper_AI& engine)
+{
+	Job job;
+	job.position = position;
+	job.settings = Settings::of(engine);
+	job.successor = false;
+	job.x = -1;
+	job.y = -1;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.clear();
+		job.generation = ++generation_;
+		//The position being solved may be the one the player has just reached
+		if ((solving_.size() > 0) && (solving_ != position.cells))
+		{
+			stale_ = true;
+			engine_.interrupt = true;
+		}
+		jobs_.push_back(std::move(job));
+	}
+	wake_.notify_all();
+}
+
+void SweeperSpeculation::cancel()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	jobs_.clear();
+	generation_++;
+	if (solving_.size() > 0)
+	{
+		stale_ = true;
+		engine_.interrupt = true;
+	}
+}
+
+void SweeperSpeculation::clear()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	jobs_.clear();
+	generation_++;
+	if (solving_.size() > 0)
+	{
+		stale_ = true;
+		engine_.interrupt = true;
+	}
+	solved_.wait(lock, [this] { return solving_.size() == 0; });
+	analyses_.clear();
+}
+
+bool SweeperSpeculation::working()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return (solving_.size() > 0) || (jobs_.size() > 0);
+}
+
+const SweeperSpeculation::Analysis* SweeperSpeculation::find(const std::vector<signed char>& cells, const Settings& settings) const
+{
+	for (auto itr = analyses_.rbegin(); itr != analyses_.rend(); itr++)
+		if ((itr->settings == settings) && (itr->cells == cells))
+			return &*itr;
+	return nullptr;
+}
+
+void SweeperSpeculation::work()
+{
+	TRACE_THREAD_NAME("speculation");
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		wake_.wait(lock, [this] { return stop_ || (jobs_.size() > 0); });
+		if (stop_)
+			return;
+		Job job = std::move(jobs_.front());
+		jobs_.pop_front();
+		if (!job.successor)
+		{
+			//Cleared together with claiming the position, so that a later start or cancel interrupts the move
+			solving_ = job.position.cells;
+			stale_ = false;
+			engine_.interrupt = false;
+		}
+		lock.unlock();
+		solve(job);
+		lock.lock();
+	}
+}
+
+//Sets up the position of job in the thread's own game and lets its engine move. A position in which the engine had to guess
+//is kept, and the successors of a position handed to start are queued behind the jobs left.
+void SweeperSpeculation::solve(const Job& job)
+{
+	TRACE_SCOPE("speculation");
+	const Settings& settings = job.settings;
+	settings.apply(engine_);
+
+	game_.loadPosition(job.position);
+	if (job.successor)
+	{
+		game_.click(job.x, job.y);
+		if (game_.gameLost() || game_.gameWon())
+			return;
+	}
+	else if (stale_)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		solving_.clear();
+		solved_.notify_all();
+		return;
+	}
+	std::vector<signed char> cells = game_.getPosition().cells;
+
+	std::vector<std::tuple<int, int>> candidates;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		const Analysis* analysis = find(cells, settings);
+		//A successor is dropped once another position has been handed over or the speculation cancelled
+		bool superseded = job.successor && (job.generation != generation_);
+		if (stop_ || superseded || (job.successor && (analysis != nullptr)))
+		{
+			solving_.clear();
+			solved_.notify_all();
+			return;
+		}
+		if (analysis != nullptr)
+		{
+			//Solved before, only its successors may be missing
+			solving_.clear();
+			solved_.notify_all();
+			candidates.push_back(std::tuple<int, int>(analysis->x, analysis->y));
+			std::vector<int> order;
+			for (int i = 0; i < (int)analysis->probabilities.size(); i++)
+				if ((analysis->cells[i] == SweeperPosition::COVERED) && (i != analysis->x + analysis->y * game_.width))
+					order.push_back(i);
+			int count = std::min((int)order.size(), branches - 1);
+			std::partial_sort(order.begin(), order.begin() + count, order.end(),
+				[analysis](int a, int b) { return analysis->probabilities[a] < analysis->probabilities[b]; });
+			for (int i = 0; i < count; i++)
+				candidates.push_back(std::tuple<int, int>(order[i] % game_.width, order[i] / game_.width));
+		}
+		else if (job.successor)
+		{
+			solving_ = cells;
+			stale_ = false;
+			engine_.interrupt = false;
+		}
+	}
+
+	if (candidates.size() == 0)
+	{
+		std::tuple<int, int> move = engine_.move(&game_);
+		Analysis analysis;
+		bool guess = (engine_.lastMove.moveType == MoveType::MOVE_PROBABILISTIC) && (move != std::tuple<int, int>(-1, -1));
+		if (guess)
+		{
+			analysis.cells = cells;
+			analysis.settings = settings;
+			analysis.x = std::get<0>(move);
+			analysis.y = std::get<1>(move);
+			analysis.probability = engine_.lastMove.probability;
+			for (int y = 0; y < game_.height; y++)
+				for (int x = 0; x < game_.width; x++)
+				{
+					VisibleCell* cell = game_.getCell(x, y);
+					analysis.probabilities.push_back(cell->mineProbability);
+					analysis.components.push_back(cell->connectedComponent);
+					analysis.constrained.push_back(cell->isConstrained);
+				}
+		}
+		if (move != std::tuple<int, int>(-1, -1))
+			candidates.push_back(move);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		bool stale = stale_;
+		solving_.clear();
+		if (!stale && guess)
+		{
+			//The next safest cells, with the known mines left out
+			std::vector<int> order;
+			for (int i = 0; i < (int)cells.size(); i++)
+			{
+				VisibleCell* cell = game_.getCell(i % game_.width, i / game_.width);
+				if ((!cell->clicked) && (!cell->knownMine) && (i != analysis.x + analysis.y * game_.width))
+					order.push_back(i);
+			}
+			int count = std::min((int)order.size(), branches - 1);
+			std::partial_sort(order.begin(), order.begin() + count, order.end(),
+				[&analysis](int a, int b) { return analysis.probabilities[a] < analysis.probabilities[b]; });
+			for (int i = 0; i < count; i++)
+				candidates.push_back(std::tuple<int, int>(order[i] % game_.width, order[i] / game_.width));
+
+			analyses_.push_back(std::move(analysis));
+			while ((int)analyses_.size() > capacity)
+				analyses_.pop_front();
+		}
+		solved_.notify_all();
+		if (stale)
+			return;
+	}
+
+	if (job.successor)
+		return;
+	std::lock_guard<std::mutex> lock(mutex_);
+	//A newer position has been handed over meanwhile
+	if (jobs_.size() > 0)
+		return;
+	for (auto itr = candidates.begin(); itr != candidates.end(); itr++)
+	{
+		Job successor;
+		successor.position = job.position;
+		successor.settings = settings;
+		successor.successor = true;
+		successor.x = std::get<0>(*itr);
+		successor.y = std::get<1>(*itr);
+		successor.generation = job.generation;
+		jobs_.push_back(std::move(successor));
+	}
+}
+
+bool SweeperSpeculation::answer(CppSweeper* game, const CppSweeper_AI& engine, std::tuple<int, int>& move, double& probability)
+{
+	std::vector<signed char> cells = game->getPosition().cells;
+	std::unique_lock<std::mutex> lock(mutex_);
+	//Solving the position again would only duplicate the work of the thread
+	solved_.wait(lock, [&] {
+		if ((solving_ == cells) && !stale_)
+			return false;
+		return !std::any_of(jobs_.begin(), jobs_.end(), [&](const Job& job) { return (!job.successor) && (job.position.cells == cells); });
+	});
+	const Analysis* analysis = find(cells, Settings::of(engine));
+	if (analysis == nullptr)
+		return false;
+
+	for (int y = 0; y < game->height; y++)
+		for (int x = 0; x < game->width; x++)
+		{
+			VisibleCell* cell = game->getCell(x, y);
+			cell->mineProbability = analysis->probabilities[x + y * game->width];
+			cell->connectedComponent = analysis->components[x + y * game->width];
+			cell->isConstrained = analysis->constrained[x + y * game->width];
+		}
+	move = std::tuple<int, int>(analysis->x, analysis->y);
+	probability = analysis->probability;
+	return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "CppSweeper.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// O------------------------------------------------------------------------------O
+// | Background analysis for interactive play. start() hands over the position	  |
+// | after each reveal; a thread with a game and an engine of its own solves it,  |
+// | then the positions after the engine's move and the next safest cells. The	  |
+// | probability maps of the positions that needed a guess are kept, and an		  |
+// | engine whose speculation member points here takes them instead of solving	  |
+// | the position again. A new position cancels the work queued for the last	  |
+// | one, and the position being solved unless it is the new one.				  |
+// O------------------------------------------------------------------------------O
+class SweeperSpeculation
+{
+private:
+	//The engine settings a position is solved with
+	struct Settings
+	{
+		StochasticMethod stochasticMethod;
+		long long maxSamples;
+		long long searchNodesPerSample;
+		bool rotate;
+		int maxProbes;
+		int gaussianMaxCells;
+		int frontierMaxStates;
+		long long exactMaxNodes;
+		int grayCodeMaxCells;
+		int bitslicedMaxCells;
+		int exactFastPathCells;
+		long long cascadeMaxNodes;
+		double cascadeConfidence;
+		int beliefMaxIterations;
+		double beliefDamping;
+		double beliefTolerance;
+		const SweeperTablebase* tablebase;
+		bool operator==(const Settings& other) const;
+		static Settings of(const CppSweeper_AI& engine);
+		void apply(CppSweeper_AI& engine) const;
+	};
+	//A position to solve: the position handed to start, or (successor) the one after clicking (x,y) in it; generation is that
+	//of the start call it descends from
+	struct Job
+	{
+		SweeperPosition position;
+		Settings settings;
+		bool successor;
+		int x, y;
+		unsigned long long generation;
+	};
+	//A solved position: its cells as in SweeperPosition::cells, the settings it was solved with, the engine's move and the map
+	//of the cells of the game
+	struct Analysis
+	{
+		std::vector<signed char> cells;
+		Settings settings;
+		int x, y;
+		double probability;
+		std::vector<double> probabilities;
+		std::vector<int> components;
+		std::vector<bool> constrained;
+	};
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable solved_;
+	std::deque<Job> jobs_;
+	std::deque<Analysis> analyses_;
+	//The cells of the position being solved, empty if none; stale_ is set once it is no longer wanted
+	std::vector<signed char> solving_;
+	std::atomic<bool> stale_{ false };
+	//Counts the calls of start, cancel and clear; a job of an older generation is no longer wanted
+	unsigned long long generation_ = 0;
+	bool stop_ = false;
+	CppSweeper game_;
+	CppSweeper_AI engine_;
+	void work();
+	void solve(const Job& job);
+	const Analysis* find(const std::vector<signed char>& cells, const Settings& settings) const;
+public:
+	//Successor positions queued after a position has been solved: the one after the engine's move and, if the engine had to
+	//guess, those after the next safest cells
+	int branches = 3;
+	//Solved positions kept; the oldest are dropped first
+	int capacity = 32;
+	SweeperSpeculation();
+	~SweeperSpeculation();
+	SweeperSpeculation(const SweeperSpeculation&) = delete;
+	SweeperSpeculation& operator=(const SweeperSpeculation&) = delete;
+	//Queues position (which must carry the mine layout, so that its successors can be revealed) to be solved with the settings
+	//of engine, dropping the jobs queued before
+	void start(const SweeperPosition& position, const CppSweeper_AI& engine);
+	//Drops the queued jobs and interrupts the one being solved; the solved positions are kept
+	void cancel();
+	//As cancel, and drops the solved positions
+	void clear();
+	bool working();
+	//If the position of game has been solved with the settings of engine, waiting for it if it is being solved, writes its map into the cells of game, sets move and probability to the engine's move and returns true
+	bool answer(CppSweeper* game, const CppSweeper_AI& engine, std::tuple<int, int>& move, double& probability);
+};
@@ -0,0 +1,278 @@
+#include "CppSweeperTablebase.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const uint8_t tablebaseMagic[4] = { 'C', 'S', 'T', 'B' };
+static const int tablebaseVersion = 1;
+static const size_t tablebaseHeaderSize = 16;
+static const size_t indexEntrySize = 16;
+static const uint8_t squareCell = 1;
+static const uint8_t squareBoundary = 2;
+
+static uint16_t read16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t read64(const uint8_t* p)
+{
+	return (uint64_t)read32(p) | ((uint64_t)read32(p + 4) << 32);
+}
+
+static void write16(std::vector<uint8_t>* out, uint16_t value)
+{
+	out->push_back((uint8_t)value);
+	out->push_back((uint8_t)(value >> 8));
+}
+
+static void write32(std::vector<uint8_t>* out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out->push_back((uint8_t)(value >> (8 * i)));
+}
+
+static void write64(std::vector<uint8_t>* out, uint64_t value)
+{
+	write32(out, (uint32_t)value);
+	write32(out, (uint32_t)(value >> 32));
+}
+
+bool ComponentPattern::build(const ConnectedComponent& component)
+{
+	key.clear();
+	cells.clear();
+	if (component.cellsToSet.size() == 0)
+		return false;
+	int minX = component.cellsToSet[0]->x, maxX = minX;
+	int minY = component.cellsToSet[0]->y, maxY = minY;
+	auto extend = [&](const VisibleCell* cell) {
+		minX = std::min(minX, cell->x);
+		maxX = std::max(maxX, cell->x);
+		minY = std::min(minY, cell->y);
+		maxY = std::max(maxY, cell->y);
+	};
+	for (auto itr = component.cellsToSet.begin(); itr != component.cellsToSet.end(); itr++)
+		extend(*itr);
+	for (auto itr = component.boundary.begin(); itr != component.boundary.end(); itr++)
+		extend(*itr);
+	int width = maxX - minX + 1;
+	int height = maxY - minY + 1;
+	if ((width > 255) || (height > 255))
+		return false;
+
+	//squares[x+y*width] in the original orientation; cellAt maps the squares of component cells to their index
+	std::vector<uint8_t> squares((size_t)width * height, 0);
+	std::vector<int> cellAt((size_t)width * height, -1);
+	for (unsigned i = 0; i < component.cellsToSet.size(); i++)
+	{
+		int square = (component.cellsToSet[i]->x - minX) + (component.cellsToSet[i]->y - minY) * width;
+		squares[square] = squareCell;
+		cellAt[square] = (int)i;
+	}
+	for (auto itr = component.boundary.begin(); itr != component.boundary.end(); itr++)
+	{
+		int need = (*itr)->neighbouringMines;
+		for (auto neighbour = (*itr)->neighbouringCells.begin(); neighbour != (*itr)->neighbouringCells.end(); neighbour++)
+			need -= (*neighbour)->knownMine ? 1 : 0;
+		if ((need < 0) || (need > 8))
+			return false;
+		squares[((*itr)->x - minX) + ((*itr)->y - minY) * width] = (uint8_t)(squareBoundary + need);
+	}
+
+	//Transformation t flips x if bit 0 is set, flips y if bit 1 is set and transposes if bit 2 is set
+	std::vector<uint8_t> candidate;
+	int best = -1;
+	for (int t = 0; t < 8; t++)
+	{
+		bool transpose = (t & 4) != 0;
+		int keyWidth = transpose ? height : width;
+		int keyHeight = transpose ? width : height;
+		candidate.assign(1, (uint8_t)keyWidth);
+		candidate.push_back((uint8_t)keyHeight);
+		for (int v = 0; v < keyHeight; v++)
+			for (int u = 0; u < keyWidth; u++)
+			{
+				int x = transpose ? v : u;
+				int y = transpose ? u : v;
+				if (t & 1)
+					x = width - 1 - x;
+				if (t & 2)
+					y = height - 1 - y;
+				candidate.push_back(squares[x + y * width]);
+			}
+		if ((best == -1) || (candidate < key))
+		{
+			key.swap(candidate);
+			best = t;
+		}
+	}
+
+	//The order of the cells of the pattern follows the squares of the chosen transformation
+	bool transpose = (best & 4) != 0;
+	int keyWidth = transpose ? height : width;
+	int keyHeight = transpose ? width : height;
+	for (int v = 0; v < keyHeight; v++)
+		for (int u = 0; u < keyWidth; u++)
+		{
+			int x = transpose ? v : u;
+			int y = transpose ? u : v;
+			if (best & 1)
+				x = width - 1 - x;
+			if (best & 2)
+				y = height - 1 - y;
+			if (cellAt[x + y * width] != -1)
+				cells.push_back(cellAt[x + y * width]);
+		}
+	return true;
+}
+
+//FNV-1a
+uint64_t ComponentPattern::hash() const
+{
+	uint64_t value = 14695981039346656037ull;
+	for (uint8_t byte : key)
+	{
+		value ^= byte;
+		value *= 1099511628211ull;
+	}
+	return value;
+}
+
+bool SweeperTablebase::open(const std::string& path)
+{
+	close();
+	if (!file_.open(path, false))
+		return false;
+	const uint8_t* data = file_.data();
+	if ((file_.size() < tablebaseHeaderSize) || (memcmp(data, tablebaseMagic, 4) != 0) || (read16(data + 4) != tablebaseVersion))
+	{
+		close();
+		return false;
+	}
+	maxCells_ = read16(data + 6);
+	entries_ = read32(data + 8);
+	if (file_.size() < tablebaseHeaderSize + (size_t)entries_ * indexEntrySize)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void SweeperTablebase::close()
+{
+	file_.close();
+	entries_ = 0;
+	maxCells_ = 0;
+}
+
+bool SweeperTablebase::lookup(const ConnectedComponent& component, ComponentSolution* solution) const
+{
+	if ((entries_ == 0) || ((int)component.cellsToSet.size() > maxCells_))
+		return false;
+	ComponentPattern pattern;
+	if (!pattern.build(component))
+		return false;
+	uint64_t hash = pattern.hash();
+
+	//Binary search for the first index entry with this hash, then compare the keys of all entries sharing it
+	const uint8_t* data = file_.data();
+	const uint8_t* index = data + tablebaseHeaderSize;
+	uint32_t low = 0, high = entries_;
+	while (low < high)
+	{
+		uint32_t middle = low + (high - low) / 2;
+		if (read64(index + (size_t)middle * indexEntrySize) < hash)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	for (uint32_t e = low; (e < entries_) && (read64(index + (size_t)e * indexEntrySize) == hash); e++)
+	{
+		size_t offset = read32(index + (size_t)e * indexEntrySize + 8);
+		if (offset + 2 > file_.size())
+			return false;
+		size_t keyLength = read16(data + offset);
+		if ((keyLength != pattern.key.size()) || (offset + 3 + keyLength > file_.size()) || (memcmp(data + offset + 2, pattern.key.data(), keyLength) != 0))
+			continue;
+		const uint8_t* entry = data + offset + 2 + keyLength;
+		int n = entry[0];
+		if ((n != (int)pattern.cells.size()) || (offset + 3 + keyLength + 4 * (size_t)(n + 1) * (n + 1) > file_.size()))
+			return false;
+		const uint8_t* counts = entry + 1;
+		solution->cells = component.cellsToSet;
+		solution->weights.resize(n + 1);
+		solution->cellWeights.assign(n, std::vector<double>(n + 1, 0.0));
+		for (int k = 0; k <= n; k++)
+			solution->weights[k] = read32(counts + 4 * k);
+		for (int j = 0; j < n; j++)
+			for (int k = 0; k <= n; k++)
+				solution->cellWeights[pattern.cells[j]][k] = read32(counts + 4 * ((size_t)(j + 1) * (n + 1) + k));
+		return true;
+	}
+	return false;
+}
+
+void SweeperTablebaseWriter::add(const ComponentPattern& pattern, const ComponentSolution& solution)
+{
+	int n = (int)pattern.cells.size();
+	if (n > cellLimit)
+		return;
+	std::vector<uint8_t> entry(1, (uint8_t)n);
+	//The solvers count assignments, so the weights are integers (at most C(n, k) < 2^32)
+	for (int k = 0; k <= n; k++)
+		write32(&entry, (uint32_t)std::llround(solution.weights[k]));
+	for (int j = 0; j < n; j++)
+		for (int k = 0; k <= n; k++)
+			write32(&entry, (uint32_t)std::llround(solution.cellWeights[pattern.cells[j]][k]));
+	entries_[pattern.key] = entry;
+	maxCells_ = std::max(maxCells_, n);
+}
+
+bool SweeperTablebaseWriter::write(const std::string& path)
+{
+	std::vector<std::pair<uint64_t, const std::vector<uint8_t>*>> order;
+	ComponentPattern pattern;
+	for (auto itr = entries_.begin(); itr != entries_.end(); itr++)
+	{
+		pattern.key = itr->first;
+		order.push_back(std::make_pair(pattern.hash(), &itr->first));
+	}
+	std::sort(order.begin(), order.end(), [](const std::pair<uint64_t, const std::vector<uint8_t>*>& a, const std::pair<uint64_t, const std::vector<uint8_t>*>& b) {
+		return (a.first < b.first) || ((a.first == b.first) && (*a.second < *b.second)); });
+
+	std::vector<uint8_t> header(tablebaseMagic, tablebaseMagic + 4);
+	write16(&header, tablebaseVersion);
+	write16(&header, (uint16_t)maxCells_);
+	write32(&header, (uint32_t)order.size());
+	write32(&header, 0);
+	std::vector<uint8_t> index;
+	std::vector<uint8_t> body;
+	size_t bodyOffset = tablebaseHeaderSize + order.size() * indexEntrySize;
+	for (auto itr = order.begin(); itr != order.end(); itr++)
+	{
+		write64(&index, itr->first);
+		write32(&index, (uint32_t)(bodyOffset + body.size()));
+		write32(&index, 0);
+		const std::vector<uint8_t>& key = *itr->second;
+		const std::vector<uint8_t>& entry = entries_.at(key);
+		write16(&body, (uint16_t)key.size());
+		body.insert(body.end(), key.begin(), key.end());
+		body.insert(body.end(), entry.begin(), entry.end());
+	}
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+	bool written = (fwrite(header.data(), 1, header.size(), file) == header.size())
+		&& (fwrite(index.data(), 1, index.size(), file) == index.size())
+		&& (fwrite(body.data(), 1, body.size(), file) == body.size());
+	return (fclose(file) == 0) && written;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "CppSweeper.h"
+#include "CppSweeperFormat.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// O------------------------------------------------------------------------------O
+// | Tablebase of solved components (all integers little endian):				  |
+// |   header:  "CSTB", uint16 version, uint16 maxCells, uint32 entryCount,		  |
+// |            uint32 reserved													  |
+// |   index:   entryCount times uint64 hash, uint32 offset, uint32 reserved,	  |
+// |            sorted by hash													  |
+// |   entry:   at offset: uint16 keyLength, the key, uint8 cells, then uint32	  |
+// |            weights[cells+1] and uint32 cellWeights[cells][cells+1] as in	  |
+// |            ComponentSolution, the cells in the order of the pattern		  |
+// O------------------------------------------------------------------------------O
+
+// O------------------------------------------------------------------------------O
+// | The canonical form of a component: the bounding box of its cells and of its  |
+// | boundary, as width, height and one byte per square (0 unrelated, 1 a cell	  |
+// | of the component, 2+n a boundary cell requiring n more mines), taken in the  |
+// | rotation or reflection with the smallest key. The solution of a component	  |
+// | depends on nothing else, so components with equal keys share it.			  |
+// O------------------------------------------------------------------------------O
+struct ComponentPattern
+{
+	std::vector<uint8_t> key;
+	//cells[j]: the index into the component's cellsToSet of the j-th component cell of the key in row-major order
+	std::vector<int> cells;
+	//Returns false if the component cannot be expressed as a pattern (bounding box wider than 255 cells)
+	bool build(const ConnectedComponent& component);
+	uint64_t hash() const;
+};
+
+// O------------------------------------------------------------------------------O
+// | Read access to a tablebase file. The file is memory mapped, so processes	  |
+// | using the same tablebase share it through the page cache, and opening it	  |
+// | only reads the header. Lookups binary search the index.					  |
+// O------------------------------------------------------------------------------O
+class SweeperTablebase
+{
+private:
+	MappedFile file_;
+	uint32_t entries_ = 0;
+	int maxCells_ = 0;
+public:
+	//Maps the file at path; returns false if it cannot be opened or is not a tablebase
+	bool open(const std::string& path);
+	void close();
+	int maxCells() const { return maxCells_; }
+	size_t size() const { return entries_; }
+	//Fills solution (in the order of component.cellsToSet) and returns true if the component's pattern is in the table
+	bool lookup(const ConnectedComponent& component, ComponentSolution* solution) const;
+};
+
+// O------------------------------------------------------------------------------O
+// | Collects solved patterns and writes them as a tablebase file.				  |
+// O------------------------------------------------------------------------------O
+class SweeperTablebaseWriter
+{
+private:
+	//Encoded entries (cells and weights, without the key) by key
+	std::map<std::vector<uint8_t>, std::vector<uint8_t>> entries_;
+	int maxCells_ = 0;
+public:
+	//Largest component a tablebase holds: its counts of assignments, at most C(32, 16), fit the uint32 of the format
+	static const int cellLimit = 32;
+	bool contains(const ComponentPattern& pattern) const { return entries_.count(pattern.key) > 0; }
+	//Adds the solution of the component of pattern; solution is in the order of the component's cellsToSet. Components of
+	//more than cellLimit cells are not added
+	void add(const ComponentPattern& pattern, const ComponentSolution& solution);
+	size_t size() const { return entries_.size(); }
+	bool write(const std::string& path);
+};
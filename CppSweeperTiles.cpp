@@ -0,0 +1,77 @@
+#include "CppSweeperTiles.h"
+#include "CppSweeperTrace.h"
+
+TilePool::TilePool(int threads)
+{
+	for (int i = 1; i < threads; i++)
+		workers_.emplace_back(&TilePool::work, this);
+}
+
+TilePool::~TilePool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (auto itr = workers_.begin(); itr != workers_.end(); itr++)
+		itr->join();
+}
+
+//Runs tiles until the counter passes the last one
+void TilePool::take(const std::function<void(int)>& task, int tasks)
+{
+	for (int tile = next_++; tile < tasks; tile = next_++)
+	{
+		TRACE_SCOPE_ARG("tile", tile);
+		task(tile);
+	}
+}
+
+void TilePool::work()
+{
+	TRACE_THREAD_NAME("tile worker");
+	long long seen = 0;
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		wake_.wait(lock, [this, seen] { return stop_ || (generation_ != seen); });
+		if (stop_)
+			return;
+		seen = generation_;
+		//A worker waking up after the run has finished finds no task
+		const std::function<void(int)>* task = task_;
+		int tasks = tasks_;
+		if (task == nullptr)
+			continue;
+		running_++;
+		lock.unlock();
+		take(*task, tasks);
+		lock.lock();
+		if (--running_ == 0)
+			done_.notify_all();
+	}
+}
+
+void TilePool::run(int tasks, const std::function<void(int)>& task)
+{
+	if ((workers_.size() == 0) || (tasks <= 1))
+	{
+		for (int tile = 0; tile < tasks; tile++)
+			task(tile);
+		return;
+	}
+	std::lock_guard<std::mutex> running(runMutex_);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		task_ = &task;
+		tasks_ = tasks;
+		next_ = 0;
+		generation_++;
+	}
+	wake_.notify_all();
+	take(task, tasks);
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_.wait(lock, [this] { return running_ == 0; });
+	task_ = nullptr;
+}
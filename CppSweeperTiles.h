@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// O------------------------------------------------------------------------------O
+// | A pool of worker threads for the tiled passes of the engine. The board is	  |
+// | split into strips of whole columns (tiles); a pass processes each tile on	  |
+// | its own, reading the cells of the neighbouring columns (the halo) but only	  |
+// | writing its own, and a sequential merge step joins the tiles at the seams.	  |
+// | Tiles are taken from a shared counter, so fast workers take more of them.	  |
+// O------------------------------------------------------------------------------O
+class TilePool
+{
+private:
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	//Held for a whole run, so that engines sharing the pool take turns
+	std::mutex runMutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+	const std::function<void(int)>* task_ = nullptr;
+	int tasks_ = 0;
+	std::atomic<int> next_{ 0 };
+	int running_ = 0;
+	long long generation_ = 0;
+	bool stop_ = false;
+	void work();
+	void take(const std::function<void(int)>& task, int tasks);
+public:
+	//Starts threads - 1 workers; the thread calling run is the last one
+	explicit TilePool(int threads);
+	~TilePool();
+	TilePool(const TilePool&) = delete;
+	TilePool& operator=(const TilePool&) = delete;
+	int threads() const { return (int)workers_.size() + 1; }
+	//Calls task(t) for t = 0..tasks-1 and returns once all calls have finished. Calls from several threads are served one
+	//after the other; task must not call run itself.
+	void run(int tasks, const std::function<void(int)>& task);
+};
+
+// O------------------------------------------------------------------------------O
+// | The column ranges of the tiles of a board.									  |
+// O------------------------------------------------------------------------------O
+struct BoardTiles
+{
+	int count = 1;
+	int width = 0;
+	BoardTiles(int width, int count) : count(count), width(width) {}
+	int begin(int tile) const { return (int)((long long)width * tile / count); }
+	int end(int tile) const { return (int)((long long)width * (tile + 1) / count); }
+};
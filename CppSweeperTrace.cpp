@@ -0,0 +1,141 @@
+#include "CppSweeperTrace.h"
+#ifdef CPPSWEEPER_TRACE
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SweeperTrace
+{
+	struct Event
+	{
+		const char* name;
+		int64_t begin;
+		int64_t duration;
+		int arg;
+		int thread;
+	};
+
+	//Events are written only by the owning thread; once full, the oldest events are overwritten
+	struct Buffer
+	{
+		static const uint64_t capacity = 1 << 14;
+		Event events[capacity];
+		std::atomic<uint64_t> written{ 0 };
+		std::atomic<bool> inUse{ false };
+	};
+
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Buffer>> buffers;
+		std::vector<std::string> threadNames;
+	};
+
+	static Registry& registry()
+	{
+		static Registry instance;
+		return instance;
+	}
+
+	//Claims a buffer for the calling thread on its first event, reusing the buffers of finished threads
+	struct ThreadSlot
+	{
+		Buffer* buffer = nullptr;
+		int thread = -1;
+
+		void acquire()
+		{
+			Registry& r = registry();
+			std::lock_guard<std::mutex> lock(r.mutex);
+			for (auto itr = r.buffers.begin(); itr != r.buffers.end() && buffer == nullptr; itr++)
+				if (!(*itr)->inUse)
+					buffer = itr->get();
+			if (buffer == nullptr)
+			{
+				r.buffers.push_back(std::unique_ptr<Buffer>(new Buffer()));
+				buffer = r.buffers.back().get();
+			}
+			buffer->inUse = true;
+			thread = (int)r.threadNames.size();
+			r.threadNames.push_back("thread " + std::to_string(thread));
+		}
+
+		~ThreadSlot()
+		{
+			if (buffer != nullptr)
+				buffer->inUse = false;
+		}
+	};
+
+	static thread_local ThreadSlot slot;
+
+	int64_t now()
+	{
+		static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	void record(const char* name, int64_t begin, int64_t end, int arg)
+	{
+		if (slot.buffer == nullptr)
+			slot.acquire();
+		uint64_t index = slot.buffer->written.load(std::memory_order_relaxed);
+		Event& e = slot.buffer->events[index & (Buffer::capacity - 1)];
+		e.name = name;
+		e.begin = begin;
+		e.duration = end - begin;
+		e.arg = arg;
+		e.thread = slot.thread;
+		slot.buffer->written.store(index + 1, std::memory_order_release);
+	}
+
+	void setThreadName(const char* name)
+	{
+		if (slot.buffer == nullptr)
+			slot.acquire();
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.threadNames[slot.thread] = name;
+	}
+
+	//Event names are string literals from the TRACE_ macros, so they are written without escaping
+	bool dump(const char* path)
+	{
+		std::ofstream out(path);
+		if (!out)
+			return false;
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		out << "{\"traceEvents\":[\n";
+		bool first = true;
+		for (unsigned t = 0; t < r.threadNames.size(); t++)
+		{
+			out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+				<< ",\"args\":{\"name\":\"" << r.threadNames[t] << "\"}}";
+			first = false;
+		}
+		for (auto itr = r.buffers.begin(); itr != r.buffers.end(); itr++)
+		{
+			Buffer& buffer = **itr;
+			uint64_t written = buffer.written.load(std::memory_order_acquire);
+			uint64_t begin = written > Buffer::capacity ? written - Buffer::capacity : 0;
+			for (uint64_t i = begin; i < written; i++)
+			{
+				const Event& e = buffer.events[i & (Buffer::capacity - 1)];
+				out << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+					<< ",\"ts\":" << e.begin << ",\"dur\":" << e.duration;
+				if (e.arg >= 0)
+					out << ",\"args\":{\"n\":" << e.arg << "}";
+				out << "}";
+				first = false;
+			}
+		}
+		out << "\n]}\n";
+		return (bool)out;
+	}
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+// O------------------------------------------------------------------------------O
+// | Optional timeline tracing. Define CPPSWEEPER_TRACE to record scoped events	  |
+// | into per-thread ring buffers, and call TRACE_DUMP to write them as Chrome	  |
+// | trace-event JSON (viewable in chrome://tracing or Perfetto).				  |
+// | Without CPPSWEEPER_TRACE all macros expand to nothing.						  |
+// O------------------------------------------------------------------------------O
+#ifdef CPPSWEEPER_TRACE
+#include <cstdint>
+
+namespace SweeperTrace
+{
+	//Microseconds since the first call
+	int64_t now();
+	void record(const char* name, int64_t begin, int64_t end, int arg);
+	void setThreadName(const char* name);
+	//Writes all buffered events to path; returns false if the file could not be written
+	bool dump(const char* path);
+}
+
+struct TraceScope
+{
+	const char* name;
+	int arg;
+	int64_t begin;
+	TraceScope(const char* name, int arg = -1) : name(name), arg(arg), begin(SweeperTrace::now()) {}
+	~TraceScope() { SweeperTrace::record(name, begin, SweeperTrace::now(), arg); }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name, arg)
+#define TRACE_THREAD_NAME(name) SweeperTrace::setThreadName(name)
+#define TRACE_DUMP(path) SweeperTrace::dump(path)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_ARG(name, arg)
+#define TRACE_THREAD_NAME(name)
+#define TRACE_DUMP(path)
+#endif
@@ -0,0 +1,717 @@
+#include "CppSweeper.h"
+#include "CppSweeperFormat.h"
+#include "CppSweeperTablebase.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// O------------------------------------------------------------------------------O
+// | A solver daemon: keeps a pool of engines and the tablebase loaded and		  |
+// | answers positions sent over a Unix domain socket. Frames (little endian):	  |
+// |   request:  uint32 length of the rest, uint32 id, uint8 method (as			  |
+// |             StochasticMethod), uint8 flags (bit 0: send the probability	  |
+// |             map), uint16 reserved, uint32 maxSamples (0: the default),		  |
+// |             then a position record as in CppSweeperFormat.h				  |
+// |   response: uint32 length of the rest, uint32 id, uint8 status (0 ok,		  |
+// |             1 malformed request), uint8 move type (0 none, 1 safe, 2		  |
+// |             guess), int16 x, int16 y, uint16 reserved, float mine			  |
+// |             probability of the move, uint16 width, uint16 height, then		  |
+// |             width*height float mine probabilities (-1 for revealed			  |
+// |             cells) if the map was asked for								  |
+// | The answers on a connection may come out of order; they carry the id of	  |
+// | their request. Workers take up to batch queued requests at a time and		  |
+// | send the answers of a batch to each connection in one write that does not	  |
+// | block; what the socket does not take is queued for the I/O thread. A		  |
+// | client that stops reading thus holds up no worker, and is dropped once		  |
+// | maxOutput bytes wait for it. Answers are cached by request, so repeated	  |
+// | positions are not solved again.											  |
+// | With --connect the program is a client: it sends the positions of a		  |
+// | corpus to a daemon over several connections and reports the throughput	  |
+// | and the latency of the answers.											  |
+// O------------------------------------------------------------------------------O
+static const size_t requestHeaderSize = 12;
+static const size_t responseHeaderSize = 20;
+static const uint32_t maxFrameSize = 1 << 24;
+
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+    interrupted = 1;
+}
+
+static void put16(std::vector<uint8_t>* out, uint16_t value)
+{
+    out->push_back((uint8_t)value);
+    out->push_back((uint8_t)(value >> 8));
+}
+
+static void put32(std::vector<uint8_t>* out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        out->push_back((uint8_t)(value >> (8 * i)));
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool sendAll(int socket, const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = send(socket, data, size, 0);
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+struct DaemonConnection
+{
+    int socket = -1;
+    //Set by the I/O thread: the peer has shut down its side and sends no more requests, resp. the connection is dropped
+    bool finished = false;
+    bool closed = false;
+    std::vector<uint8_t> input;
+    //Requests queued or being answered
+    std::atomic<int> outstanding{ 0 };
+    //Answers the socket did not take at once; the I/O thread has sent output[0..outputSent). failed is set instead when a send
+    //fails or more than maxOutput bytes would wait.
+    std::mutex outputMutex;
+    std::vector<uint8_t> output;
+    size_t outputSent = 0;
+    bool failed = false;
+    ~DaemonConnection()
+    {
+        if (socket >= 0)
+            close(socket);
+    }
+};
+
+struct DaemonRequest
+{
+    std::shared_ptr<DaemonConnection> connection;
+    //The request without its length
+    std::vector<uint8_t> frame;
+};
+
+class DaemonSweeper
+{
+public:
+    std::string path = "/tmp/CppSweeper.sock";
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int batch = 16;
+    long long maxSamples = 100000;
+    //Answers kept in the cache; the oldest are dropped first
+    int cacheSize = 4096;
+    //Bytes of answers a connection may leave unread before it is dropped
+    long long maxOutput = 64 << 20;
+    SweeperTablebase tablebase;
+    bool hasTablebase = false;
+
+    //Client mode
+    std::string connectPath;
+    std::string loadPath;
+    int clients = 4;
+    //Requests a client keeps in flight
+    int window = 32;
+    int repeat = 1;
+    int method = (int)StochasticMethod::METHOD_BACKTRACKING;
+    bool probabilities = true;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<DaemonRequest> queue;
+    bool stopping = false;
+    std::mutex cacheMutex;
+    std::unordered_map<std::string, std::vector<uint8_t>> cache;
+    std::deque<std::string> cacheOrder;
+    std::atomic<long long> served{ 0 };
+    std::atomic<long long> cacheHits{ 0 };
+    std::atomic<long long> batches{ 0 };
+    //The workers write a byte to wakePipe[1] after queueing answers, so that the I/O thread leaves poll to send them
+    int wakePipe[2] = { -1, -1 };
+
+    //Appends the answer to frame (a request without its length) to out
+    void answer(const std::vector<uint8_t>& frame, CppSweeper& game, CppSweeper_AI& AI, std::vector<uint8_t>* out)
+    {
+        size_t start = out->size();
+        put32(out, 0);
+        put32(out, (frame.size() >= 4) ? get32(frame.data()) : 0);
+        std::string key((const char*)frame.data() + std::min<size_t>(frame.size(), 4), (const char*)frame.data() + frame.size());
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            auto cached = cache.find(key);
+            if (cached != cache.end())
+            {
+                out->insert(out->end(), cached->second.begin(), cached->second.end());
+                uint32_t length = (uint32_t)(out->size() - start - 4);
+                for (int i = 0; i < 4; i++)
+                    (*out)[start + i] = (uint8_t)(length >> (8 * i));
+                cacheHits++;
+                return;
+            }
+        }
+
+        size_t body = out->size();
+        SweeperRecord record;
+        bool valid = (frame.size() > requestHeaderSize) && (frame[4] <= (uint8_t)StochasticMethod::METHOD_BELIEF) &&
+            (decodeRecord(frame.data() + requestHeaderSize, frame.size() - requestHeaderSize, &record) == frame.size() - requestHeaderSize) &&
+            (record.kind == RecordKind::RECORD_POSITION) && (record.width > 0) && (record.height > 0);
+        if (!valid)
+        {
+            out->push_back(1);
+            out->resize(out->size() + responseHeaderSize - 9, 0);
+        }
+        else
+        {
+            SweeperPosition position;
+            record.toPosition(&position);
+            AI.stochasticMethod = (StochasticMethod)frame[4];
+            uint32_t samples = get32(frame.data() + 8);
+            AI.maxSamples = (samples > 0) ? samples : maxSamples;
+            game.loadPosition(position);
+            //A position without a cell left to click is answered with no move
+            std::tuple<int, int> move(-1, -1);
+            if (game.moveLeft())
+                move = AI.move(&game);
+            uint8_t moveType = 0;
+            float probability = 0.0f;
+            if (std::get<0>(move) >= 0)
+            {
+                moveType = (AI.lastMove.moveType == MoveType::MOVE_DETERMINISTIC) ? 1 : 2;
+                probability = (moveType == 1) ? 0.0f : (float)AI.lastMove.probability;
+            }
+            bool map = (frame[5] & 1) != 0;
+            //A deduced move does not estimate probabilities; run the stochastic method anyway to send them
+            if (map && (moveType == 1))
+                AI.stages().stochasticMove(&game);
+
+            out->push_back(0);
+            out->push_back(moveType);
+            put16(out, (uint16_t)(int16_t)std::get<0>(move));
+            put16(out, (uint16_t)(int16_t)std::get<1>(move));
+            put16(out, 0);
+            uint32_t bits;
+            std::memcpy(&bits, &probability, 4);
+            put32(out, bits);
+            put16(out, (uint16_t)game.width);
+            put16(out, (uint16_t)game.height);
+            if (map)
+                for (int y = 0; y < game.height; y++)
+                    for (int x = 0; x < game.width; x++)
+                    {
+                        VisibleCell* cell = game.getCell(x, y);
+                        float p = cell->clicked ? -1.0f : (float)cell->mineProbability;
+                        std::memcpy(&bits, &p, 4);
+                        put32(out, bits);
+                    }
+        }
+        uint32_t length = (uint32_t)(out->size() - start - 4);
+        for (int i = 0; i < 4; i++)
+            (*out)[start + i] = (uint8_t)(length >> (8 * i));
+        served++;
+
+        if (valid && (cacheSize > 0))
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            if (cache.emplace(key, std::vector<uint8_t>(out->begin() + body, out->end())).second)
+            {
+                cacheOrder.push_back(key);
+                while ((int)cacheOrder.size() > cacheSize)
+                {
+                    cache.erase(cacheOrder.front());
+                    cacheOrder.pop_front();
+                }
+            }
+        }
+    }
+
+    //Sends out to connection without blocking, behind the answers queued before; returns true if the I/O thread has to take
+    //over, because some of it was queued or the connection is to be dropped
+    bool deliver(DaemonConnection& connection, const std::vector<uint8_t>& out)
+    {
+        std::lock_guard<std::mutex> lock(connection.outputMutex);
+        if (connection.failed)
+            return false;
+        size_t offset = 0;
+        if (connection.output.size() == 0)
+            while (offset < out.size())
+            {
+                ssize_t sent = send(connection.socket, out.data() + offset, out.size() - offset, MSG_DONTWAIT);
+                if (sent >= 0)
+                    offset += (size_t)sent;
+                else if (errno != EINTR)
+                {
+                    connection.failed = (errno != EAGAIN) && (errno != EWOULDBLOCK);
+                    break;
+                }
+            }
+        if (offset == out.size())
+            return connection.failed;
+        if ((long long)(connection.output.size() - connection.outputSent + out.size() - offset) > maxOutput)
+            connection.failed = true;
+        else if (!connection.failed)
+            connection.output.insert(connection.output.end(), out.begin() + offset, out.end());
+        return true;
+    }
+
+    //A full pipe wakes the I/O thread already, so a failed write is ignored
+    void wake()
+    {
+        uint8_t byte = 0;
+        ssize_t written = write(wakePipe[1], &byte, 1);
+        (void)written;
+    }
+
+    void worker()
+    {
+        CppSweeper game;
+        CppSweeper_AI AI;
+        game.AI = &AI;
+        if (hasTablebase)
+            AI.tablebase = &tablebase;
+        std::vector<DaemonRequest> taken;
+        std::vector<uint8_t> out;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return stopping || (queue.size() > 0); });
+                if (queue.size() == 0)
+                    return;
+                while (((int)taken.size() < batch) && (queue.size() > 0))
+                {
+                    taken.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            batches++;
+            //The answers for one connection go out together, in the order of its requests
+            std::stable_sort(taken.begin(), taken.end(),
+                [](const DaemonRequest& a, const DaemonRequest& b) { return a.connection.get() < b.connection.get(); });
+            int answered = 0;
+            bool queued = false;
+            for (size_t i = 0; i < taken.size(); i++)
+            {
+                answer(taken[i].frame, game, AI, &out);
+                answered++;
+                if ((i + 1 == taken.size()) || (taken[i + 1].connection != taken[i].connection))
+                {
+                    queued |= deliver(*taken[i].connection, out);
+                    taken[i].connection->outstanding -= answered;
+                    answered = 0;
+                    out.clear();
+                }
+            }
+            taken.clear();
+            if (queued)
+                wake();
+        }
+    }
+
+    //Moves the complete frames received on connection into the queue; returns false if a frame is too large
+    bool queueFrames(const std::shared_ptr<DaemonConnection>& connection)
+    {
+        std::vector<uint8_t>& input = connection->input;
+        size_t offset = 0;
+        std::vector<DaemonRequest> frames;
+        while (input.size() - offset >= 4)
+        {
+            uint32_t length = get32(input.data() + offset);
+            if (length > maxFrameSize)
+                return false;
+            if (input.size() - offset - 4 < length)
+                break;
+            frames.push_back(DaemonRequest{ connection, std::vector<uint8_t>(input.begin() + offset + 4, input.begin() + offset + 4 + length) });
+            offset += 4 + length;
+        }
+        input.erase(input.begin(), input.begin() + offset);
+        if (frames.size() > 0)
+        {
+            connection->outstanding += (int)frames.size();
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                for (auto itr = frames.begin(); itr != frames.end(); itr++)
+                    queue.push_back(std::move(*itr));
+            }
+            if (frames.size() > 1)
+                queueReady.notify_all();
+            else
+                queueReady.notify_one();
+        }
+        return true;
+    }
+
+    //Sends as much of the queued answers of connection as the socket takes without blocking; returns false if the connection
+    //has to be dropped
+    bool flush(DaemonConnection& connection)
+    {
+        std::lock_guard<std::mutex> lock(connection.outputMutex);
+        if (connection.failed)
+            return false;
+        while (connection.outputSent < connection.output.size())
+        {
+            ssize_t sent = send(connection.socket, connection.output.data() + connection.outputSent,
+                connection.output.size() - connection.outputSent, MSG_DONTWAIT);
+            if (sent < 0)
+                return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+            connection.outputSent += (size_t)sent;
+        }
+        connection.output.clear();
+        connection.outputSent = 0;
+        return true;
+    }
+
+    bool hasOutput(DaemonConnection& connection)
+    {
+        std::lock_guard<std::mutex> lock(connection.outputMutex);
+        return connection.outputSent < connection.output.size();
+    }
+
+    bool serve()
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Socket path too long: " << path << std::endl;
+            return false;
+        }
+        std::strcpy(address.sun_path, path.c_str());
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+        {
+            std::cerr << "Cannot create a socket" << std::endl;
+            return false;
+        }
+        //Only the socket of a daemon that is no longer running is replaced
+        struct stat existing;
+        if (lstat(path.c_str(), &existing) == 0)
+        {
+            if (!S_ISSOCK(existing.st_mode))
+            {
+                std::cerr << path << " exists and is not a socket" << std::endl;
+                close(listener);
+                return false;
+            }
+            int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+            bool live = (probe >= 0) && (connect(probe, (sockaddr*)&address, sizeof(address)) == 0);
+            if (probe >= 0)
+                close(probe);
+            if (live)
+            {
+                std::cerr << "A daemon is already listening on " << path << std::endl;
+                close(listener);
+                return false;
+            }
+            unlink(path.c_str());
+        }
+        if ((bind(listener, (sockaddr*)&address, sizeof(address)) != 0) || (listen(listener, 64) != 0))
+        {
+            std::cerr << "Cannot listen on " << path << std::endl;
+            close(listener);
+            return false;
+        }
+        if ((pipe(wakePipe) != 0) || (fcntl(wakePipe[0], F_SETFL, O_NONBLOCK) != 0) || (fcntl(wakePipe[1], F_SETFL, O_NONBLOCK) != 0))
+        {
+            std::cerr << "Cannot create the wake-up pipe" << std::endl;
+            close(listener);
+            unlink(path.c_str());
+            return false;
+        }
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        std::signal(SIGPIPE, SIG_IGN);
+        std::cerr << "Listening on " << path << " with " << threads << " workers" << std::endl;
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++)
+            workers.emplace_back(&DaemonSweeper::worker, this);
+
+        std::vector<std::shared_ptr<DaemonConnection>> connections;
+        std::vector<pollfd> fds;
+        std::vector<uint8_t> buffer(1 << 16);
+        while (!interrupted)
+        {
+            //Send the answers queued since the last round; a connection that has sent all its requests is kept until they are
+            //answered. Requests still queued keep a dropped connection (and its socket) alive until a worker has taken them.
+            for (auto itr = connections.begin(); itr != connections.end(); itr++)
+            {
+                DaemonConnection& connection = **itr;
+                if (!flush(connection))
+                {
+                    shutdown(connection.socket, SHUT_RDWR);
+                    connection.closed = true;
+                }
+                else if (connection.finished && (connection.outstanding == 0) && !hasOutput(connection))
+                    connection.closed = true;
+            }
+            connections.erase(std::remove_if(connections.begin(), connections.end(),
+                [](const std::shared_ptr<DaemonConnection>& connection) { return connection->closed; }), connections.end());
+
+            fds.clear();
+            fds.push_back(pollfd{ listener, POLLIN, 0 });
+            fds.push_back(pollfd{ wakePipe[0], POLLIN, 0 });
+            for (auto itr = connections.begin(); itr != connections.end(); itr++)
+                fds.push_back(pollfd{ (*itr)->socket, (short)(((*itr)->finished ? 0 : POLLIN) | (hasOutput(**itr) ? POLLOUT : 0)), 0 });
+            if (poll(fds.data(), fds.size(), 200) <= 0)
+                continue;
+            if (fds[0].revents & POLLIN)
+            {
+                int client = accept(listener, nullptr, nullptr);
+                if (client >= 0)
+                {
+                    connections.push_back(std::make_shared<DaemonConnection>());
+                    connections.back()->socket = client;
+                }
+            }
+            if (fds[1].revents & POLLIN)
+                while (read(wakePipe[0], buffer.data(), buffer.size()) > 0)
+                    ;
+            for (size_t i = 2; i < fds.size(); i++)
+            {
+                std::shared_ptr<DaemonConnection>& connection = connections[i - 2];
+                if (fds[i].revents & POLLIN)
+                {
+                    ssize_t received = recv(connection->socket, buffer.data(), buffer.size(), 0);
+                    if (received <= 0)
+                    {
+                        //The peer may still read the answers to the requests it has sent
+                        connection->finished = true;
+                        continue;
+                    }
+                    connection->input.insert(connection->input.end(), buffer.begin(), buffer.begin() + received);
+                    if (!queueFrames(connection))
+                    {
+                        shutdown(connection->socket, SHUT_RDWR);
+                        connection->closed = true;
+                    }
+                }
+                //Hung up in both directions, nobody reads the answers
+                else if (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL))
+                    connection->closed = true;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto itr = workers.begin(); itr != workers.end(); itr++)
+            itr->join();
+        for (auto itr = connections.begin(); itr != connections.end(); itr++)
+            if (!(*itr)->closed)
+                flush(**itr);
+        close(wakePipe[0]);
+        close(wakePipe[1]);
+        close(listener);
+        unlink(path.c_str());
+        std::cerr << "Answered " << served + cacheHits << " requests (" << cacheHits << " from the cache) in " << batches << " batches" << std::endl;
+        return true;
+    }
+
+    //Sends frames[first], frames[first + step], ... with up to window in flight; collects the latency of each answer
+    void client(const std::vector<std::vector<uint8_t>>& frames, size_t first, size_t step, std::vector<double>* latencies, long long* failures)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, connectPath.c_str(), sizeof(address.sun_path) - 1);
+        int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if ((sock < 0) || (connect(sock, (sockaddr*)&address, sizeof(address)) != 0))
+        {
+            if (sock >= 0)
+                close(sock);
+            *failures += (long long)((frames.size() * repeat - first + step - 1) / step);
+            return;
+        }
+        std::vector<std::chrono::steady_clock::time_point> sent(frames.size() * repeat);
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> buffer(1 << 16);
+        size_t next = first;
+        size_t total = frames.size() * repeat;
+        int inFlight = 0;
+        while ((next < total) || (inFlight > 0))
+        {
+            while ((next < total) && (inFlight < window))
+            {
+                std::vector<uint8_t> frame = frames[next % frames.size()];
+                for (int i = 0; i < 4; i++)
+                    frame[4 + i] = (uint8_t)(next >> (8 * i));
+                sent[next] = std::chrono::steady_clock::now();
+                if (!sendAll(sock, frame.data(), frame.size()))
+                    break;
+                next += step;
+                inFlight++;
+            }
+            ssize_t received = recv(sock, buffer.data(), buffer.size(), 0);
+            if (received <= 0)
+                break;
+            input.insert(input.end(), buffer.begin(), buffer.begin() + received);
+            size_t offset = 0;
+            while ((input.size() - offset >= 4) && (input.size() - offset - 4 >= get32(input.data() + offset)))
+            {
+                uint32_t length = get32(input.data() + offset);
+                const uint8_t* response = input.data() + offset + 4;
+                uint32_t id = get32(response);
+                if ((length < responseHeaderSize - 4) || (response[4] != 0) || (id >= sent.size()))
+                    (*failures)++;
+                else
+                    latencies->push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent[id]).count());
+                inFlight--;
+                offset += 4 + length;
+            }
+            input.erase(input.begin(), input.begin() + offset);
+        }
+        *failures += inFlight;
+        close(sock);
+    }
+
+    bool runClients()
+    {
+        SweeperCorpus corpus;
+        if (!corpus.open(loadPath))
+        {
+            std::cerr << "Cannot read corpus " << loadPath << std::endl;
+            return false;
+        }
+        std::vector<std::vector<uint8_t>> frames;
+        SweeperRecord record;
+        while (corpus.next(&record))
+        {
+            if (record.kind != RecordKind::RECORD_POSITION)
+                continue;
+            SweeperPosition position;
+            record.toPosition(&position);
+            //The daemon only sees what a player sees
+            position.mines.clear();
+            std::vector<uint8_t> frame;
+            put32(&frame, 0);
+            put32(&frame, 0);
+            frame.push_back((uint8_t)method);
+            frame.push_back(probabilities ? 1 : 0);
+            put16(&frame, 0);
+            put32(&frame, 0);
+            encodeRecord(position, &frame);
+            uint32_t length = (uint32_t)frame.size() - 4;
+            for (int i = 0; i < 4; i++)
+                frame[i] = (uint8_t)(length >> (8 * i));
+            frames.push_back(std::move(frame));
+        }
+        if (frames.size() == 0)
+        {
+            std::cerr << "No positions in " << loadPath << std::endl;
+            return false;
+        }
+        if (frames.size() * repeat > 0xFFFFFFFFull)
+            repeat = 1;
+
+        std::vector<std::vector<double>> latencies(clients);
+        std::vector<long long> failures(clients, 0);
+        std::vector<std::thread> threadsRunning;
+        auto begin = std::chrono::steady_clock::now();
+        for (int c = 0; c < clients; c++)
+            threadsRunning.emplace_back(&DaemonSweeper::client, this, std::cref(frames), (size_t)c, (size_t)clients, &latencies[c], &failures[c]);
+        for (auto itr = threadsRunning.begin(); itr != threadsRunning.end(); itr++)
+            itr->join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        std::vector<double> all;
+        long long failed = 0;
+        for (int c = 0; c < clients; c++)
+        {
+            all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+            failed += failures[c];
+        }
+        std::sort(all.begin(), all.end());
+        double p50 = (all.size() > 0) ? all[all.size() / 2] : 0.0;
+        double p99 = (all.size() > 0) ? all[std::min(all.size() - 1, all.size() * 99 / 100)] : 0.0;
+        std::cout << "{\"requests\":" << all.size() << ",\"failed\":" << failed << ",\"clients\":" << clients << ",\"seconds\":" << seconds
+            << ",\"requests_per_sec\":" << (seconds > 0 ? all.size() / seconds : 0.0) << ",\"p50_us\":" << p50 << ",\"p99_us\":" << p99 << "}" << std::endl;
+        return failed == 0;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    DaemonSweeper daemon;
+    bool usage = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            usage = true;
+        else if (arg == "--socket")
+            daemon.path = argv[++i];
+        else if (arg == "--threads")
+            daemon.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--batch")
+            daemon.batch = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--samples")
+            daemon.maxSamples = std::atoll(argv[++i]);
+        else if (arg == "--cache")
+            daemon.cacheSize = std::atoi(argv[++i]);
+        else if (arg == "--max-output")
+            daemon.maxOutput = std::max(1LL, std::atoll(argv[++i]));
+        else if (arg == "--tablebase")
+        {
+            if (!daemon.tablebase.open(argv[++i]))
+            {
+                std::cerr << "Cannot read tablebase " << argv[i] << std::endl;
+                return 1;
+            }
+            daemon.hasTablebase = true;
+        }
+        else if (arg == "--connect")
+            daemon.connectPath = argv[++i];
+        else if (arg == "--load")
+            daemon.loadPath = argv[++i];
+        else if (arg == "--clients")
+            daemon.clients = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--window")
+            daemon.window = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--repeat")
+            daemon.repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--method")
+            daemon.method = std::atoi(argv[++i]);
+        else
+            usage = true;
+        if (usage)
+            break;
+    }
+    if (usage || ((daemon.connectPath.size() > 0) && (daemon.loadPath.size() == 0)))
+    {
+        std::cerr << "Usage: DaemonSweeper [--socket path] [--threads n] [--batch n] [--samples n] [--cache answers] [--max-output bytes] [--tablebase file]" << std::endl;
+        std::cerr << "       DaemonSweeper --connect path --load corpus [--clients n] [--window n] [--repeat n] [--method n]" << std::endl;
+        return 1;
+    }
+    if (daemon.connectPath.size() > 0)
+        return daemon.runClients() ? 0 : 1;
+    return daemon.serve() ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include "CppSweeper.h"
+#include "CppSweeperFormat.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+// O------------------------------------------------------------------------------O
+// | Accuracy of the sampled probabilities against their cost. For every guess	  |
+// | position of a corpus the exact probabilities are computed once; then each	  |
+// | setting of maxSamples and rotate is run on the position and compared to	  |
+// | them. Each setting is written as one JSON object per line; settings that	  |
+// | no other setting beats in both time and error are marked as pareto.		  |
+// O------------------------------------------------------------------------------O
+struct SamplingSetting
+{
+    long long maxSamples;
+    bool rotate;
+    double time = 0.0;
+    double absoluteError = 0.0;
+    long long cells = 0;
+    double regret = 0.0;
+    int bestChosen = 0;
+    int guesses = 0;
+};
+
+class SamplingSweeper
+{
+public:
+    std::vector<long long> sampleCounts = { 1000, 3000, 10000, 30000, 100000, 300000, 1000000 };
+    long long maxNodes = 20000000;
+    int limit = -1;
+    unsigned int seed = 1;
+    std::vector<SamplingSetting> settings;
+    int positions = 0;
+    int skipped = 0;
+
+    void runPosition(const SweeperPosition& position)
+    {
+        CppSweeper exactGame;
+        CppSweeper_AI exactAI;
+        exactGame.AI = &exactAI;
+        exactGame.loadPosition(position);
+        if (!exactAI.stages().exactProbabilities(&exactGame, maxNodes))
+        {
+            skipped++;
+            return;
+        }
+        int cellCount = position.width * position.height;
+        std::vector<double> exact(cellCount, -1.0);
+        double best = 1.0;
+        for (int i = 0; i < cellCount; i++)
+        {
+            VisibleCell* cell = exactGame.getCell(i % position.width, i / position.width);
+            if (!cell->clicked)
+            {
+                exact[i] = cell->mineProbability;
+                best = std::min(best, exact[i]);
+            }
+        }
+
+        bool counted = false;
+        for (auto setting = settings.begin(); setting != settings.end(); setting++)
+        {
+            CppSweeper game;
+            CppSweeper_AI AI;
+            game.seed(seed);
+            game.AI = &AI;
+            AI.maxSamples = setting->maxSamples;
+            AI.rotate = setting->rotate;
+            //Measure the sampled search even on positions the engine would solve exactly
+            AI.exactFastPathCells = 0;
+            game.loadPosition(position);
+            std::tuple<int, int> move = AI.move(&game);
+            //The deduction stages are the same for every setting, so a position either is a guess for all settings or for none
+            if ((AI.lastMove.moveType != MoveType::MOVE_PROBABILISTIC) || (std::get<0>(move) < 0))
+                return;
+            if (!counted)
+                positions++;
+            counted = true;
+
+            setting->guesses++;
+            setting->time += AI.lastStats().totalTime;
+            for (int i = 0; i < cellCount; i++)
+                if (exact[i] >= 0.0)
+                {
+                    setting->absoluteError += std::fabs(game.getCell(i % position.width, i / position.width)->mineProbability - exact[i]);
+                    setting->cells++;
+                }
+            double chosen = exact[std::get<0>(move) + std::get<1>(move) * position.width];
+            setting->regret += chosen - best;
+            if (chosen - best < 1e-9)
+                setting->bestChosen++;
+        }
+    }
+
+    bool run(const std::string& path)
+    {
+        for (auto samples = sampleCounts.begin(); samples != sampleCounts.end(); samples++)
+            for (int rotate = 1; rotate >= 0; rotate--)
+            {
+                SamplingSetting setting;
+                setting.maxSamples = *samples;
+                setting.rotate = rotate != 0;
+                settings.push_back(setting);
+            }
+
+        SweeperCorpus corpus;
+        if (!corpus.open(path))
+        {
+            std::cerr << "Cannot read corpus " << path << std::endl;
+            return false;
+        }
+        SweeperRecord record;
+        SweeperPosition position;
+        while (((limit < 0) || (positions < limit)) && corpus.next(&record))
+            if (record.kind == RecordKind::RECORD_POSITION)
+            {
+                record.toPosition(&position);
+                runPosition(position);
+            }
+        return !corpus.corrupt();
+    }
+
+    void report()
+    {
+        for (auto setting = settings.begin(); setting != settings.end(); setting++)
+        {
+            double time = setting->guesses > 0 ? setting->time / setting->guesses : 0.0;
+            double error = setting->cells > 0 ? setting->absoluteError / setting->cells : 0.0;
+            bool pareto = true;
+            for (auto other = settings.begin(); other != settings.end(); other++)
+            {
+                double otherTime = other->guesses > 0 ? other->time / other->guesses : 0.0;
+                double otherError = other->cells > 0 ? other->absoluteError / other->cells : 0.0;
+                if ((otherTime <= time) && (otherError <= error) && ((otherTime < time) || (otherError < error)))
+                    pareto = false;
+            }
+            std::cout << "{\"max_samples\":" << setting->maxSamples << ",\"rotate\":" << (setting->rotate ? "true" : "false")
+                << ",\"positions\":" << setting->guesses << ",\"us_per_guess\":" << time << ",\"mean_abs_error\":" << error
+                << ",\"best_cell_rate\":" << (setting->guesses > 0 ? (double)setting->bestChosen / setting->guesses : 0.0)
+                << ",\"mean_regret\":" << (setting->guesses > 0 ? setting->regret / setting->guesses : 0.0)
+                << ",\"pareto\":" << (pareto ? "true" : "false") << "}" << std::endl;
+        }
+        std::cerr << positions << " positions, " << skipped << " skipped because the exact enumeration exceeded " << maxNodes << " nodes" << std::endl;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    SamplingSweeper sweeper;
+    std::string path;
+    bool usage = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--samples") && (i + 1 < argc))
+        {
+            sweeper.sampleCounts.clear();
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ','))
+                sweeper.sampleCounts.push_back(std::atoll(item.c_str()));
+        }
+        else if ((arg == "--nodes") && (i + 1 < argc))
+            sweeper.maxNodes = std::atoll(argv[++i]);
+        else if ((arg == "--limit") && (i + 1 < argc))
+            sweeper.limit = std::atoi(argv[++i]);
+        else if ((arg == "--seed") && (i + 1 < argc))
+            sweeper.seed = (unsigned int)std::atoi(argv[++i]);
+        else if ((arg.size() > 0) && (arg[0] != '-') && (path.size() == 0))
+            path = arg;
+        else
+            usage = true;
+    }
+    if (usage || (path.size() == 0))
+    {
+        std::cerr << "Usage: SamplingSweeper [--samples n,n,...] [--nodes n] [--limit positions] [--seed s] corpus" << std::endl;
+        return 1;
+    }
+    if (!sweeper.run(path))
+        return 1;
+    sweeper.report();
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "CppSweeper.h"
+#include "CppSweeperFormat.h"
+#include "CppSweeperTablebase.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+// O------------------------------------------------------------------------------O
+// | Builds a tablebase of solved components. The number of possible patterns	  |
+// | grows too fast to list them all, so the patterns are collected from the	  |
+// | positions in which the engine guesses: in seeded games on the given board	  |
+// | sizes and in the positions of corpus files. Every distinct pattern of at	  |
+// | most maxCells cells is solved once, exactly. The format stores counts of	  |
+// | assignments as uint32, so maxCells is at most 32.							  |
+// O------------------------------------------------------------------------------O
+struct BoardSize
+{
+    int width;
+    int height;
+    int mineCount;
+};
+
+class TablebaseSweeper
+{
+public:
+    int maxCells = 12;
+    int games = 2000;
+    unsigned int seedBase = 1;
+    long long maxNodes = 20000000;
+    std::vector<BoardSize> sizes;
+    std::vector<std::string> corpusPaths;
+    SweeperTablebaseWriter writer;
+    long long components = 0;
+
+    //Adds the components last labelled by AI
+    void addComponents(CppSweeper_AI& AI)
+    {
+        std::vector<ConnectedComponent>& labelled = AI.stages().components();
+        for (auto component = labelled.begin(); component != labelled.end(); component++)
+        {
+            if ((component->cellsToSet.size() == 0) || ((int)component->cellsToSet.size() > maxCells))
+                continue;
+            components++;
+            ComponentPattern pattern;
+            if (!pattern.build(*component) || writer.contains(pattern))
+                continue;
+            ComponentSolution solution;
+            if (AI.stages().solveComponent(*component, maxNodes, &solution))
+                writer.add(pattern, solution);
+        }
+    }
+
+    void playGames(const BoardSize& size)
+    {
+        CppSweeper game;
+        CppSweeper_AI AI;
+        game.AI = &AI;
+        game.width = size.width;
+        game.height = size.height;
+        game.mineCount = size.mineCount;
+        for (int g = 0; g < games; g++)
+        {
+            game.seed(seedBase + g);
+            game.resetGame();
+            while (!game.gameWon() && !game.gameLost())
+            {
+                std::tuple<int, int> move = AI.move(&game);
+                if (move == std::tuple<int, int>(-1, -1))
+                    break;
+                if (AI.lastMove.moveType == MoveType::MOVE_PROBABILISTIC)
+                    addComponents(AI);
+                game.click(std::get<0>(move), std::get<1>(move));
+            }
+        }
+    }
+
+    bool readCorpus(const std::string& path)
+    {
+        SweeperCorpus corpus;
+        if (!corpus.open(path))
+        {
+            std::cerr << "Cannot read corpus " << path << std::endl;
+            return false;
+        }
+        SweeperRecord record;
+        SweeperPosition position;
+        while (corpus.next(&record))
+            if (record.kind == RecordKind::RECORD_POSITION)
+            {
+                record.toPosition(&position);
+                CppSweeper game;
+                CppSweeper_AI AI;
+                game.AI = &AI;
+                game.loadPosition(position);
+                std::vector<VisibleCell*> boundary;
+                std::vector<VisibleCell*> cellsToSet;
+                AI.stages().collectBoundary(&game, &boundary, &cellsToSet);
+                AI.stages().labelConnectedComponents(&game, &cellsToSet, &boundary);
+                addComponents(AI);
+            }
+        return !corpus.corrupt();
+    }
+
+    bool run(const std::string& path)
+    {
+        for (auto itr = corpusPaths.begin(); itr != corpusPaths.end(); itr++)
+            if (!readCorpus(*itr))
+                return false;
+        for (auto itr = sizes.begin(); itr != sizes.end(); itr++)
+            playGames(*itr);
+        if (!writer.write(path))
+        {
+            std::cerr << "Cannot write " << path << std::endl;
+            return false;
+        }
+        std::cerr << writer.size() << " patterns of up to " << maxCells << " cells from " << components << " components written to " << path << std::endl;
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    TablebaseSweeper builder;
+    std::string path;
+    bool usage = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--cells") && (i + 1 < argc))
+            builder.maxCells = std::atoi(argv[++i]);
+        else if ((arg == "--games") && (i + 1 < argc))
+            builder.games = std::atoi(argv[++i]);
+        else if ((arg == "--seed") && (i + 1 < argc))
+            builder.seedBase = (unsigned int)std::atoi(argv[++i]);
+        else if ((arg == "--size") && (i + 1 < argc))
+        {
+            std::stringstream size(argv[++i]);
+            BoardSize board;
+            char separator;
+            if (size >> board.width >> separator >> board.height >> separator >> board.mineCount)
+                builder.sizes.push_back(board);
+            else
+                usage = true;
+        }
+        else if ((arg == "--corpus") && (i + 1 < argc))
+            builder.corpusPaths.push_back(argv[++i]);
+        else if ((arg.size() > 0) && (arg[0] != '-') && (path.size() == 0))
+            path = arg;
+        else
+            usage = true;
+    }
+    if (usage || (path.size() == 0) || (builder.maxCells < 1) || (builder.maxCells > SweeperTablebaseWriter::cellLimit))
+    {
+        std::cerr << "Usage: TablebaseSweeper [--cells n] [--games n] [--seed s] [--size WxHxM]... [--corpus file]... tablebase" << std::endl;
+        return 1;
+    }
+    if (builder.sizes.size() == 0)
+        builder.sizes = { { 9, 9, 10 }, { 16, 16, 40 }, { 30, 16, 99 } };
+    return builder.run(path) ? 0 : 1;
+}
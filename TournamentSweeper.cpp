@@ -0,0 +1,585 @@
+#include "CppSweeper.h"
+#include "CppSweeperTablebase.h"
+#include "CppSweeperEventLog.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+// O------------------------------------------------------------------------------O
+// | An engine configuration taking part in a tournament, given on the command	  |
+// | line as method[:samples][:rotate|:norotate], e.g. average or				  |
+// | backtracking:100000:norotate												  |
+// O------------------------------------------------------------------------------O
+struct EngineConfig
+{
+    std::string name;
+    StochasticMethod method = StochasticMethod::METHOD_BACKTRACKING;
+    long long maxSamples = 1000000;
+    bool rotate = true;
+
+    bool parse(const std::string& text)
+    {
+        name = text;
+        std::stringstream stream(text);
+        std::string token;
+        std::getline(stream, token, ':');
+        if (token == "backtracking")
+            method = StochasticMethod::METHOD_BACKTRACKING;
+        else if (token == "exact")
+            method = StochasticMethod::METHOD_EXACT;
+        else if (token == "cascade")
+            method = StochasticMethod::METHOD_CASCADE;
+        else if (token == "belief")
+            method = StochasticMethod::METHOD_BELIEF;
+        else if (token == "average")
+            method = StochasticMethod::METHOD_AVGCONSTRAINT;
+        else if (token == "single")
+            method = StochasticMethod::METHOD_SINGLECONSTRAINT;
+        else if (token == "random")
+            method = StochasticMethod::METHOD_RND;
+        else
+            return false;
+        while (std::getline(stream, token, ':'))
+        {
+            if (token == "rotate")
+                rotate = true;
+            else if (token == "norotate")
+                rotate = false;
+            else if ((token.size() > 0) && (token.find_first_not_of("0123456789") == std::string::npos))
+                maxSamples = std::atoll(token.c_str());
+            else
+                return false;
+        }
+        return true;
+    }
+};
+
+// O------------------------------------------------------------------------------O
+// | The outcome of one board for one configuration. Times and probabilities	  |
+// | are kept per board and summed in board order, so that the totals do not	  |
+// | depend on how the boards were split over threads or shards.				  |
+// O------------------------------------------------------------------------------O
+struct GameResult
+{
+    char won = 0;
+    uint32_t moves = 0;
+    uint32_t guesses = 0;
+    //Sum of the mine probabilities of the guesses, and of the logarithms of the probabilities of surviving them
+    double guessProbability = 0.0;
+    double logSurvival = 0.0;
+    //Engine time of all moves, in microseconds
+    double time = 0.0;
+};
+
+// O------------------------------------------------------------------------------O
+// | Plays every configuration on the same seeded boards. Since each board is	  |
+// | played by all configurations, the win-rate difference of two configurations  |
+// | is estimated from paired outcomes, whose variance only stems from the boards |
+// | on which the configurations disagree.										  |
+// | A tournament can be split into shards, each playing a contiguous range of	  |
+// | the boards (--shard i/n), in separate processes. A shard writes its		  |
+// | results (--out) and --merge joins the files of all shards into the report	  |
+// | of the whole tournament, which is the same as if one process had played	  |
+// | it. Result files (little endian):											  |
+// |   header:  "CSTR", uint32 version, uint32 width, height, mineCount,		  |
+// |            seedBase, games (of the whole tournament), first game, game		  |
+// |            count, configurations, then per configuration a uint16 length	  |
+// |            and the name as given to --config								  |
+// |   results: per game of the shard and configuration: uint8 won, uint32		  |
+// |            moves, uint32 guesses, double guessProbability, logSurvival	  |
+// |            and time													  |
+// | A file is written under a temporary name and renamed once complete, so a	  |
+// | shard found complete is not played again when an interrupted campaign is	  |
+// | restarted.																	  |
+// O------------------------------------------------------------------------------O
+class TournamentSweeper
+{
+public:
+    int games = 1000;
+    int threads = 1;
+    unsigned int seedBase = 1;
+    //The shard played by this process, and the number of shards the games are split into
+    int shard = 0;
+    int shards = 1;
+    int width = 30;
+    int height = 16;
+    int mineCount = 99;
+    std::vector<EngineConfig> configs;
+    static const uint32_t resultVersion = 1;
+    //Shared by all workers; the mapping is shared with other processes using the same file
+    SweeperTablebase tablebase;
+    //Receives every move of every game if open (tagged with the index of the configuration)
+    SweeperEventLog events;
+    //Indexed [config][game]
+    std::vector<std::vector<GameResult>> results;
+    //Whether the result of a game is known
+    std::vector<char> played;
+
+    int firstGame() const { return (int)((long long)games * shard / shards); }
+    int endGame() const { return (int)((long long)games * (shard + 1) / shards); }
+
+    void playGames(std::atomic<int>* nextGame)
+    {
+        CppSweeper game;
+        CppSweeper_AI AI;
+        game.AI = &AI;
+        if (tablebase.size() > 0)
+            AI.tablebase = &tablebase;
+        game.width = width;
+        game.height = height;
+        game.mineCount = mineCount;
+        SweeperEventLog::Writer* log = events.isOpen() ? events.writer() : nullptr;
+        for (int g = (*nextGame)++; g < endGame(); g = (*nextGame)++)
+        {
+            for (unsigned c = 0; c < configs.size(); c++)
+            {
+                GameResult& result = results[c][g];
+                AI.stochasticMethod = configs[c].method;
+                AI.maxSamples = configs[c].maxSamples;
+                AI.rotate = configs[c].rotate;
+                game.seed(seedBase + g);
+                game.resetGame();
+                while (!game.gameWon() && !game.gameLost())
+                {
+                    std::tuple<int, int> move = AI.move(&game);
+                    if (move == std::tuple<int, int>(-1, -1))
+                        break;
+                    result.time += AI.lastStats().totalTime;
+                    result.moves++;
+                    if (AI.lastMove.moveType == MoveType::MOVE_PROBABILISTIC)
+                    {
+                        result.guesses++;
+                        result.guessProbability += AI.lastMove.probability;
+                        result.logSurvival += std::log(std::max(1.0 - AI.lastMove.probability, 1e-300));
+                    }
+                    game.click(std::get<0>(move), std::get<1>(move));
+                    if (log != nullptr)
+                    {
+                        SweeperEvent event = SweeperEvent();
+                        event.game = seedBase + g;
+                        event.moveNo = result.moves;
+                        event.probability = (AI.lastMove.moveType == MoveType::MOVE_PROBABILISTIC) ? (float)AI.lastMove.probability : 0.0f;
+                        event.solveTime = (float)AI.lastStats().totalTime;
+                        event.x = (int16_t)std::get<0>(move);
+                        event.y = (int16_t)std::get<1>(move);
+                        event.moveType = (uint8_t)AI.lastMove.moveType;
+                        event.outcome = (uint8_t)(game.gameWon() ? EventOutcome::OUTCOME_WON : (game.gameLost() ? EventOutcome::OUTCOME_LOST : EventOutcome::OUTCOME_CONTINUE));
+                        event.tag = (uint16_t)c;
+                        log->append(event);
+                    }
+                }
+                result.won = game.gameWon() ? 1 : 0;
+            }
+            played[g] = 1;
+        }
+    }
+
+    void allocate()
+    {
+        results.assign(configs.size(), std::vector<GameResult>(games));
+        played.assign(games, 0);
+    }
+
+    void run()
+    {
+        allocate();
+        std::atomic<int> nextGame(firstGame());
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+            workers.push_back(std::thread(&TournamentSweeper::playGames, this, &nextGame));
+        for (auto itr = workers.begin(); itr != workers.end(); itr++)
+            itr->join();
+    }
+
+    static void put16(std::vector<uint8_t>* out, uint16_t value)
+    {
+        out->push_back((uint8_t)value);
+        out->push_back((uint8_t)(value >> 8));
+    }
+
+    static void put32(std::vector<uint8_t>* out, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            out->push_back((uint8_t)(value >> (8 * i)));
+    }
+
+    static void putDouble(std::vector<uint8_t>* out, double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, 8);
+        for (int i = 0; i < 8; i++)
+            out->push_back((uint8_t)(bits >> (8 * i)));
+    }
+
+    static uint32_t get32(const uint8_t* p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static double getDouble(const uint8_t* p)
+    {
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits |= (uint64_t)p[i] << (8 * i);
+        double value;
+        std::memcpy(&value, &bits, 8);
+        return value;
+    }
+
+    //Writes the results of this shard to path
+    bool save(const std::string& path)
+    {
+        std::vector<uint8_t> data = { 'C', 'S', 'T', 'R' };
+        put32(&data, resultVersion);
+        put32(&data, (uint32_t)width);
+        put32(&data, (uint32_t)height);
+        put32(&data, (uint32_t)mineCount);
+        put32(&data, seedBase);
+        put32(&data, (uint32_t)games);
+        put32(&data, (uint32_t)firstGame());
+        put32(&data, (uint32_t)(endGame() - firstGame()));
+        put32(&data, (uint32_t)configs.size());
+        for (auto itr = configs.begin(); itr != configs.end(); itr++)
+        {
+            put16(&data, (uint16_t)itr->name.size());
+            data.insert(data.end(), itr->name.begin(), itr->name.end());
+        }
+        for (int g = firstGame(); g < endGame(); g++)
+            for (unsigned c = 0; c < configs.size(); c++)
+            {
+                const GameResult& result = results[c][g];
+                data.push_back((uint8_t)result.won);
+                put32(&data, result.moves);
+                put32(&data, result.guesses);
+                putDouble(&data, result.guessProbability);
+                putDouble(&data, result.logSurvival);
+                putDouble(&data, result.time);
+            }
+
+        std::string temporary = path + ".tmp";
+        FILE* file = fopen(temporary.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+        bool written = (fwrite(data.data(), 1, data.size(), file) == data.size());
+        if ((fclose(file) != 0) || !written)
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        std::remove(path.c_str());
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    //Reads a result file into the results. The first file read sets the board size, seeds, games and configurations;
+    //the files read after it must agree and must not hold games already read.
+    bool load(const std::string& path, bool first, std::string* error)
+    {
+        std::vector<uint8_t> data;
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            *error = "cannot read";
+            return false;
+        }
+        uint8_t buffer[1 << 16];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            data.insert(data.end(), buffer, buffer + read);
+        fclose(file);
+
+        const size_t headerSize = 40;
+        const size_t resultSize = 33;
+        if ((data.size() < headerSize) || (std::memcmp(data.data(), "CSTR", 4) != 0) || (get32(&data[4]) != resultVersion))
+        {
+            *error = "not a result file";
+            return false;
+        }
+        int fileWidth = (int)get32(&data[8]), fileHeight = (int)get32(&data[12]), fileMines = (int)get32(&data[16]);
+        unsigned int fileSeed = get32(&data[20]);
+        int fileGames = (int)get32(&data[24]), fileFirst = (int)get32(&data[28]), fileCount = (int)get32(&data[32]);
+        size_t configCount = get32(&data[36]);
+        size_t offset = headerSize;
+        std::vector<std::string> names;
+        for (size_t c = 0; c < configCount; c++)
+        {
+            if (offset + 2 > data.size())
+                break;
+            size_t length = data[offset] | ((size_t)data[offset + 1] << 8);
+            offset += 2;
+            if (offset + length > data.size())
+                break;
+            names.push_back(std::string(data.begin() + offset, data.begin() + offset + length));
+            offset += length;
+        }
+        if ((names.size() != configCount) || (fileGames <= 0) || (fileFirst < 0) || (fileCount < 0) || (fileFirst + fileCount > fileGames) ||
+            (data.size() - offset != (size_t)fileCount * configCount * resultSize))
+        {
+            *error = "truncated or malformed";
+            return false;
+        }
+
+        if (first)
+        {
+            width = fileWidth;
+            height = fileHeight;
+            mineCount = fileMines;
+            seedBase = fileSeed;
+            games = fileGames;
+            configs.clear();
+            for (auto itr = names.begin(); itr != names.end(); itr++)
+            {
+                configs.push_back(EngineConfig());
+                if (!configs.back().parse(*itr))
+                {
+                    *error = "unknown configuration " + *itr;
+                    return false;
+                }
+            }
+            allocate();
+        }
+        else
+        {
+            bool same = (fileWidth == width) && (fileHeight == height) && (fileMines == mineCount) && (fileSeed == seedBase) && (fileGames == games) &&
+                (names.size() == configs.size());
+            for (size_t c = 0; same && (c < names.size()); c++)
+                same = (names[c] == configs[c].name);
+            if (!same)
+            {
+                *error = "from a different tournament";
+                return false;
+            }
+        }
+        for (int g = fileFirst; g < fileFirst + fileCount; g++)
+            if (played[g])
+            {
+                *error = "overlaps another shard at game " + std::to_string(g);
+                return false;
+            }
+
+        for (int g = fileFirst; g < fileFirst + fileCount; g++)
+        {
+            for (size_t c = 0; c < configCount; c++)
+            {
+                const uint8_t* p = &data[offset];
+                GameResult& result = results[c][g];
+                result.won = (char)p[0];
+                result.moves = get32(p + 1);
+                result.guesses = get32(p + 5);
+                result.guessProbability = getDouble(p + 9);
+                result.logSurvival = getDouble(p + 17);
+                result.time = getDouble(p + 25);
+                offset += resultSize;
+            }
+            played[g] = 1;
+        }
+        return true;
+    }
+
+    //Whether path holds the complete results of the shard this process is to play
+    bool complete(const std::string& path)
+    {
+        TournamentSweeper previous;
+        std::string error;
+        if (!previous.load(path, true, &error) || (previous.width != width) || (previous.height != height) || (previous.mineCount != mineCount) ||
+            (previous.seedBase != seedBase) || (previous.games != games) || (previous.configs.size() != configs.size()))
+            return false;
+        for (unsigned c = 0; c < configs.size(); c++)
+            if (previous.configs[c].name != configs[c].name)
+                return false;
+        for (int g = firstGame(); g < endGame(); g++)
+            if (!previous.played[g])
+                return false;
+        results = previous.results;
+        played = previous.played;
+        return true;
+    }
+
+    //Reports on the games of the range [begin, end)
+    void report(int begin, int end)
+    {
+        const double z = 1.96;
+        int count = end - begin;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << count << " games on " << width << "x" << height << " with " << mineCount << " mines, seeds " << seedBase + begin << "-" << seedBase + end - 1 << std::endl;
+        for (unsigned c = 0; c < configs.size(); c++)
+        {
+            int won = 0;
+            long long moves = 0, guesses = 0;
+            double time = 0.0, guessProbability = 0.0, survival = 0.0;
+            for (int g = begin; g < end; g++)
+            {
+                const GameResult& result = results[c][g];
+                won += result.won;
+                moves += result.moves;
+                guesses += result.guesses;
+                time += result.time;
+                guessProbability += result.guessProbability;
+                survival += std::exp(result.logSurvival);
+            }
+            double p = (double)won / count;
+            double halfWidth = z * std::sqrt(p * (1.0 - p) / count);
+            std::cout << std::setw(32) << std::left << configs[c].name << std::right << " win rate " << 100.0 * p << "% +- " << 100.0 * halfWidth
+                << "%, " << (moves > 0 ? time / moves : 0.0) << "us per move, " << (double)guesses / count << " guesses per game at "
+                << 100.0 * (guesses > 0 ? guessProbability / guesses : 0.0) << "% mine probability, "
+                << 100.0 * survival / count << "% of the games expected to survive their guesses" << std::endl;
+        }
+
+        //Each configuration against the first: mean and standard error of the paired differences
+        for (unsigned c = 1; c < configs.size(); c++)
+        {
+            int better = 0, worse = 0;
+            for (int g = begin; g < end; g++)
+            {
+                better += (results[c][g].won > results[0][g].won);
+                worse += (results[c][g].won < results[0][g].won);
+            }
+            double mean = (double)(better - worse) / count;
+            double variance = ((double)(better + worse) / count - mean * mean) * count / std::max(count - 1, 1);
+            double standardError = std::sqrt(variance / count);
+            std::cout << configs[c].name << " vs " << configs[0].name << ": " << (mean >= 0 ? "+" : "") << 100.0 * mean << "% [" << 100.0 * (mean - z * standardError)
+                << "%, " << 100.0 * (mean + z * standardError) << "%], " << better << " boards won only by " << configs[c].name << ", " << worse << " only by " << configs[0].name;
+            if ((std::fabs(mean) > z * standardError) && (standardError > 0.0))
+                std::cout << ", significant";
+            else if (mean != 0.0)
+                std::cout << ", about " << (long long)std::ceil(z * z * variance / (mean * mean)) << " games needed for significance";
+            std::cout << std::endl;
+        }
+    }
+};
+
+int main(int argc, char** argv)
+{
+    TournamentSweeper tournament;
+    tournament.threads = std::max(1u, std::thread::hardware_concurrency());
+    bool usage = false;
+    std::string out;
+    std::string events;
+    std::vector<std::string> merge;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--merge")
+        {
+            merge.assign(argv + i + 1, argv + argc);
+            usage |= (merge.size() == 0);
+            break;
+        }
+        if (i + 1 >= argc)
+            usage = true;
+        else if (arg == "--games")
+            tournament.games = std::atoi(argv[++i]);
+        else if (arg == "--threads")
+            tournament.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed")
+            tournament.seedBase = (unsigned int)std::atoi(argv[++i]);
+        else if (arg == "--size")
+        {
+            std::stringstream size(argv[++i]);
+            char separator;
+            if (!(size >> tournament.width >> separator >> tournament.height >> separator >> tournament.mineCount))
+                usage = true;
+        }
+        else if (arg == "--shard")
+        {
+            std::stringstream shard(argv[++i]);
+            char separator;
+            if (!(shard >> tournament.shard >> separator >> tournament.shards) || (tournament.shards < 1) || (tournament.shard < 0) ||
+                (tournament.shard >= tournament.shards))
+                usage = true;
+        }
+        else if (arg == "--out")
+            out = argv[++i];
+        else if (arg == "--events")
+            events = argv[++i];
+        else if (arg == "--tablebase")
+        {
+            if (!tournament.tablebase.open(argv[++i]))
+            {
+                std::cerr << "Cannot read tablebase " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--config")
+        {
+            EngineConfig config;
+            usage |= !config.parse(argv[++i]);
+            tournament.configs.push_back(config);
+        }
+        else
+            usage = true;
+    }
+    if (tournament.configs.size() == 0)
+    {
+        const char* defaults[] = { "backtracking", "backtracking:norotate", "exact", "cascade", "belief", "average", "single" };
+        for (auto name : defaults)
+        {
+            tournament.configs.push_back(EngineConfig());
+            tournament.configs.back().parse(name);
+        }
+    }
+    if (usage || (tournament.games <= 0) || (tournament.shards > tournament.games))
+    {
+        std::cerr << "Usage: TournamentSweeper [--games n] [--threads n] [--seed s] [--size WxHxM] [--tablebase file] [--config method[:samples][:rotate|:norotate]]..." << std::endl;
+        std::cerr << "                         [--shard i/n] [--out results] [--events log]" << std::endl;
+        std::cerr << "       TournamentSweeper --merge results..." << std::endl;
+        return 1;
+    }
+
+    if (merge.size() > 0)
+    {
+        std::string error;
+        for (size_t i = 0; i < merge.size(); i++)
+            if (!tournament.load(merge[i], i == 0, &error))
+            {
+                std::cerr << merge[i] << ": " << error << std::endl;
+                return 1;
+            }
+        int missing = (int)std::count(tournament.played.begin(), tournament.played.end(), 0);
+        if (missing > 0)
+        {
+            std::cerr << missing << " of " << tournament.games << " games are in none of the files" << std::endl;
+            return 1;
+        }
+        tournament.report(0, tournament.games);
+        return 0;
+    }
+
+    if ((out.size() > 0) && tournament.complete(out))
+        std::cerr << out << " already holds the results of shard " << tournament.shard << "/" << tournament.shards << std::endl;
+    else
+    {
+        if ((events.size() > 0) && !tournament.events.open(events))
+        {
+            std::cerr << "Cannot write " << events << std::endl;
+            return 1;
+        }
+        tournament.run();
+        if (tournament.events.isOpen())
+        {
+            bool written = tournament.events.close();
+            std::cerr << tournament.events.written() << " events written to " << events << ", " << tournament.events.dropped() << " dropped" << std::endl;
+            if (!written)
+            {
+                std::cerr << "Cannot write " << events << std::endl;
+                return 1;
+            }
+        }
+        if ((out.size() > 0) && !tournament.save(out))
+        {
+            std::cerr << "Cannot write " << out << std::endl;
+            return 1;
+        }
+    }
+    tournament.report(tournament.firstGame(), tournament.endGame());
+    return 0;
+}
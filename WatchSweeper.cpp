@@ -0,0 +1,101 @@
+#include "CppSweeper.h"
+#include "CppSweeperShared.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+// O------------------------------------------------------------------------------O
+// | Follows the map an engine publishes into shared memory (cf.				  |
+// | CppSweeper_AI::publisher) and prints it whenever it changes. The engine	  |
+// | does not wait for the viewer, which only reads.							  |
+// O------------------------------------------------------------------------------O
+class WatchSweeper
+{
+public:
+    std::string name = "CppSweeper";
+    int interval = 100;
+    //Maps printed before exiting, 0: until interrupted
+    int count = 0;
+    SweeperMapReader reader;
+
+    void print(const SharedMapSnapshot& snapshot)
+    {
+        const SharedMapCounters& counters = snapshot.counters;
+        std::cout << "Sequence " << snapshot.sequence << ": " << counters.width << "x" << counters.height << ", " << counters.mineCount
+            << " mines (" << counters.knownMines << " known), move " << counters.moveNo << " at (" << counters.moveX << "," << counters.moveY
+            << ")";
+        if (counters.moveType == (int32_t)MoveType::MOVE_PROBABILISTIC)
+            std::cout << ", mine probability " << counters.moveProbability;
+        std::cout << std::endl;
+        for (int y = 0; y < counters.height; y++)
+        {
+            for (int x = 0; x < counters.width; x++)
+            {
+                int i = x + y * counters.width;
+                std::string s;
+                if (snapshot.cells[i] >= 0)
+                    s = std::to_string(snapshot.cells[i]);
+                else if (snapshot.cells[i] == SharedMapSnapshot::KNOWN_MINE)
+                    s = "*";
+                else if (snapshot.cells[i] == SweeperPosition::FLAGGED)
+                    s = "F";
+                else if ((snapshot.labels[i] == -1) || (snapshot.probabilities[i] < 0.0f))
+                    s = ".";
+                else
+                    s = std::to_string((int)(snapshot.probabilities[i] * 100.0f + 0.5f)) + "%";
+                std::cout << std::string(5 - s.size(), ' ') << s;
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "Moves " << counters.moves << " (" << counters.guesses << " guesses), games " << counters.wins << " won, " << counters.losses
+            << " lost, " << counters.components << " components (largest " << counters.largestComponent << "), " << counters.samples << " samples, "
+            << counters.searchNodes << " nodes, last move " << counters.moveTime << "us" << std::endl;
+    }
+
+    bool run()
+    {
+        if (!reader.open(name))
+        {
+            std::cerr << "Cannot open shared map " << name << std::endl;
+            return false;
+        }
+        uint64_t seen = 0;
+        int printed = 0;
+        SharedMapSnapshot snapshot;
+        while ((count == 0) || (printed < count))
+        {
+            uint64_t sequence = reader.sequence();
+            if ((sequence != seen) && reader.read(&snapshot))
+            {
+                seen = snapshot.sequence;
+                print(snapshot);
+                printed++;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        }
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    WatchSweeper watch;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--name")
+            watch.name = argv[i + 1];
+        else if (arg == "--interval")
+            watch.interval = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--count")
+            watch.count = std::atoi(argv[i + 1]);
+        else
+        {
+            std::cerr << "Usage: WatchSweeper [--name segment] [--interval ms] [--count maps]" << std::endl;
+            return 1;
+        }
+    }
+    return watch.run() ? 0 : 1;
+}